@@ -0,0 +1,106 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "CompactRegion.hpp"
+#include "bed_io.hpp"
+#include "string_pool.hpp"
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using std::runtime_error;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::vector;
+
+static StringPool &region_name_pool() {
+  static StringPool *pool = [] {
+    StringPool *p = new StringPool;
+    p->assign("X"); // region_names::default_name_id
+    return p;
+  }();
+  return *pool;
+}
+
+region_names::name_id_type region_names::assign(const string_view name) {
+  return region_name_pool().assign(name);
+}
+
+const string &region_names::name(const name_id_type id) {
+  return region_name_pool().get(id);
+}
+
+size_t region_names::size() { return region_name_pool().size(); }
+
+CompactRegion::CompactRegion()
+    : start(0), end(0), name(region_names::default_name_id), score(0),
+      strand('+') {
+  static const chrom_id_type null_chrom = chrom_dict::assign("(NULL)");
+  chrom = null_chrom;
+}
+
+uint32_t CompactRegion::checked_pos(const size_t pos) {
+  if (pos > std::numeric_limits<uint32_t>::max())
+    throw runtime_error("position too large for CompactRegion: " +
+                        to_string(pos));
+  return pos;
+}
+
+string CompactRegion::tostring() const {
+  std::ostringstream s;
+  s << get_chrom() << "\t" << start << "\t" << end;
+  const string &n = get_name();
+  if (!n.empty())
+    s << "\t" << n << "\t" << score << "\t" << strand;
+  return s.str();
+}
+
+size_t CompactRegion::distance(const CompactRegion &other) const {
+  if (chrom != other.chrom)
+    return std::numeric_limits<size_t>::max();
+  else if (overlaps(other) || other.overlaps(*this))
+    return 0;
+  else
+    return (end < other.start) ? other.start - end + 1 : start - other.end + 1;
+}
+
+void ReadBEDFile(const string &filename, vector<CompactRegion> &regions) {
+  read_bed_file(filename, regions);
+}
+
+void WriteBEDFile(const string &filename, const vector<CompactRegion> &regions,
+                  const string &track_name) {
+  BedWriter out(filename);
+  if (!track_name.empty())
+    out.write("track name=" + track_name + "\n");
+  for (const auto &r : regions)
+    out.write(r);
+  out.close();
+}
+
+void WriteBEDFile(const string &filename,
+                  const vector<vector<CompactRegion>> &regions,
+                  const string &track_name) {
+  BedWriter out(filename);
+  if (!track_name.empty())
+    out.write("track name=" + track_name + "\n");
+  for (const auto &v : regions)
+    for (const auto &r : v)
+      out.write(r);
+  out.close();
+}
@@ -0,0 +1,172 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef COMPACT_REGION_HPP
+#define COMPACT_REGION_HPP
+
+#include "GenomicRegion.hpp"
+#include "chrom_dict.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* region_names: the names of all CompactRegion objects, each kept once
+ * and shared by every region with that name. Ids are dense and never
+ * change; the id of "X", the default name, is 0. Like chrom_dict, this
+ * is safe to use from many threads.
+ */
+namespace region_names {
+typedef uint32_t name_id_type;
+static const name_id_type default_name_id = 0;
+name_id_type assign(const std::string_view name);
+const std::string &name(const name_id_type id);
+size_t size();
+} // namespace region_names
+
+/* CompactRegion: a region with the same interface as GenomicRegion that
+ * takes 24 bytes instead of about 64. Positions are 32 bits, the chrom
+ * is an id in chrom_dict and the name is an id in region_names, so a
+ * name repeated across millions of regions is stored once. Positions
+ * given as size_t are checked, and a runtime_error is thrown if they
+ * don't fit in 32 bits. Names are compared by id, which is the same as
+ * comparing them as strings, since each distinct name has one id.
+ */
+class CompactRegion {
+public:
+  CompactRegion();
+  CompactRegion(const std::string &c, const size_t sta, const size_t e,
+                const std::string_view n, const float sc, const char str)
+      : chrom(chrom_dict::assign(c)), start(checked_pos(sta)),
+        end(checked_pos(e)), name(region_names::assign(n)), score(sc),
+        strand(str) {}
+  CompactRegion(const std::string &c, const size_t sta, const size_t e)
+      : chrom(chrom_dict::assign(c)), start(checked_pos(sta)),
+        end(checked_pos(e)), name(region_names::default_name_id), score(0),
+        strand('+') {}
+  // the id must come from chrom_dict
+  CompactRegion(const chrom_id_type c, const size_t sta, const size_t e,
+                const std::string_view n, const float sc, const char str)
+      : chrom(c), start(checked_pos(sta)), end(checked_pos(e)),
+        name(region_names::assign(n)), score(sc), strand(str) {}
+  explicit CompactRegion(const GenomicRegion &r)
+      : CompactRegion(r.get_chrom_id(), r.get_start(), r.get_end(),
+                      r.get_name(), r.get_score(), r.get_strand()) {}
+  GenomicRegion to_genomic_region() const {
+    return GenomicRegion(chrom, start, end, get_name(), score, strand);
+  }
+  std::string tostring() const;
+
+  // accessors
+  const std::string &get_chrom() const { return chrom_dict::name(chrom); }
+  chrom_id_type get_chrom_id() const { return chrom; }
+  uint32_t get_start() const { return start; }
+  uint32_t get_end() const { return end; }
+  uint32_t get_width() const { return (end > start) ? end - start : 0; }
+  const std::string &get_name() const { return region_names::name(name); }
+  region_names::name_id_type get_name_id() const { return name; }
+  float get_score() const { return score; }
+  char get_strand() const { return strand; }
+  bool pos_strand() const { return (strand == '+'); }
+  bool neg_strand() const { return (strand == '-'); }
+
+  // mutators
+  void set_chrom(const std::string &new_chrom) {
+    chrom = chrom_dict::assign(new_chrom);
+  }
+  void set_start(const size_t new_start) { start = checked_pos(new_start); }
+  void set_end(const size_t new_end) { end = checked_pos(new_end); }
+  void set_name(const std::string_view n) { name = region_names::assign(n); }
+  void set_score(const float s) { score = s; }
+  void set_strand(const char s) { strand = s; }
+  // the id must come from chrom_dict
+  void set_chrom_id(const chrom_id_type c) { chrom = c; }
+  // the id must come from region_names
+  void set_name_id(const region_names::name_id_type n) { name = n; }
+
+  // comparison functions, all the same as for GenomicRegion
+  bool contains(const CompactRegion &other) const {
+    return chrom == other.chrom && start <= other.start && other.end <= end;
+  }
+  bool overlaps(const CompactRegion &other) const {
+    return chrom == other.chrom &&
+           ((start < other.end && other.end <= end) ||
+            (start <= other.start && other.start < end) ||
+            other.contains(*this));
+  }
+  size_t distance(const CompactRegion &other) const;
+  bool operator<(const CompactRegion &rhs) const {
+    if (chrom != rhs.chrom)
+      return chrom_dict::less(chrom, rhs.chrom);
+    return start < rhs.start ||
+           (start == rhs.start &&
+            (end < rhs.end || (end == rhs.end && strand < rhs.strand)));
+  }
+  bool less1(const CompactRegion &rhs) const {
+    if (chrom != rhs.chrom)
+      return chrom_dict::less(chrom, rhs.chrom);
+    return end < rhs.end ||
+           (end == rhs.end &&
+            (start < rhs.start || (start == rhs.start && strand < rhs.strand)));
+  }
+  bool operator<=(const CompactRegion &rhs) const { return !(rhs < *this); }
+  bool operator==(const CompactRegion &rhs) const {
+    return chrom == rhs.chrom && start == rhs.start && end == rhs.end &&
+           name == rhs.name && score == rhs.score && strand == rhs.strand;
+  }
+  bool operator!=(const CompactRegion &rhs) const { return !(*this == rhs); }
+
+  bool same_chrom(const CompactRegion &other) const {
+    return chrom == other.chrom;
+  }
+
+private:
+  static uint32_t checked_pos(const size_t pos);
+
+  chrom_id_type chrom;
+  uint32_t start;
+  uint32_t end;
+  region_names::name_id_type name;
+  float score;
+  char strand;
+};
+
+static_assert(sizeof(CompactRegion) <= 24, "CompactRegion should be small");
+
+template <class T> T &operator>>(T &the_stream, CompactRegion &r) {
+  std::string buffer;
+  if (getline(the_stream, buffer))
+    r = CompactRegion(GenomicRegion(buffer));
+  return the_stream;
+}
+
+template <class T> T &operator<<(T &the_stream, const CompactRegion &r) {
+  the_stream << r.tostring();
+  return the_stream;
+}
+
+void ReadBEDFile(const std::string &filename,
+                 std::vector<CompactRegion> &regions);
+
+void WriteBEDFile(const std::string &filename,
+                  const std::vector<CompactRegion> &regions,
+                  const std::string &track_name = "");
+void WriteBEDFile(const std::string &filename,
+                  const std::vector<std::vector<CompactRegion>> &regions,
+                  const std::string &track_name = "");
+
+#endif
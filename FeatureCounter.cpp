@@ -0,0 +1,238 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "FeatureCounter.hpp"
+#include "chrom_dict.hpp"
+#include "cigar_utils.hpp"
+#include "parallel_tasks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::unordered_map;
+using std::vector;
+
+count_summary &count_summary::operator+=(const count_summary &other) {
+  assigned += other.assigned;
+  no_feature += other.no_feature;
+  ambiguous += other.ambiguous;
+  multi_mapping += other.multi_mapping;
+  low_mapq += other.low_mapq;
+  unmapped += other.unmapped;
+  return *this;
+}
+
+FeatureCounter::FeatureCounter(const vector<GenomicRegion> &regions,
+                               const bool group_by_name)
+    : index(regions), feature_of(regions.size()), strands(regions.size()) {
+  unordered_map<string, size_t> feature_ids;
+  for (size_t i = 0; i < regions.size(); ++i) {
+    strands[i] = regions[i].get_strand();
+    if (!group_by_name) {
+      feature_of[i] = i;
+      names.push_back(regions[i].get_name());
+      continue;
+    }
+    const auto it = feature_ids.emplace(regions[i].get_name(), names.size());
+    if (it.second)
+      names.push_back(regions[i].get_name());
+    feature_of[i] = it.first->second;
+  }
+}
+
+void FeatureCounter::add_block(read_hits &hits, const char strand,
+                               const count_options &opts) const {
+  index.overlapping(hits.block, hits.regions);
+  for (const auto r : hits.regions) {
+    // features without a strand match reads on either
+    const char s = strands[r];
+    const bool has_strand = (s == '+' || s == '-');
+    if (opts.strand == count_strand::unstranded || !has_strand ||
+        (opts.strand == count_strand::forward) == (s == strand))
+      hits.features.push_back(feature_of[r]);
+  }
+}
+
+void FeatureCounter::add_read(read_hits &hits, vector<double> &counts,
+                              count_summary &summary,
+                              const count_options &opts) const {
+  vector<size_t> &f = hits.features;
+  // a read can overlap several regions of the same feature
+  if (f.size() > 1) {
+    std::sort(std::begin(f), std::end(f));
+    f.erase(std::unique(std::begin(f), std::end(f)), std::end(f));
+  }
+  if (f.empty())
+    ++summary.no_feature;
+  else if (f.size() > 1 && opts.overlap == count_overlap::unique)
+    ++summary.ambiguous;
+  else {
+    ++summary.assigned;
+    const double w =
+        opts.overlap == count_overlap::fraction ? 1.0 / f.size() : 1.0;
+    for (const auto i : f)
+      counts[i] += w;
+  }
+  f.clear();
+}
+
+// the number of places the read maps, from the NH tag, or 1
+static size_t get_n_hits(const sam_rec &sr) {
+  for (const auto &tag : sr.tags)
+    if (tag.compare(0, 5, "NH:i:") == 0)
+      return std::strtoul(tag.c_str() + 5, nullptr, 10);
+  return 1;
+}
+
+void FeatureCounter::count_range(const vector<sam_rec> &reads,
+                                 const size_t first, const size_t last,
+                                 vector<double> &counts, count_summary &summary,
+                                 const count_options &opts) const {
+  read_hits hits;
+  // reads are usually grouped by chrom, so the last name is kept
+  string_view chrom_name;
+  chrom_id_type chrom = 0;
+  bool has_chrom = false;
+  for (size_t i = first; i < last; ++i) {
+    const sam_rec &sr = reads[i];
+    if (check_flag(sr, samflags::read_unmapped) || sr.rname == "*" ||
+        sr.cigar == "*" || sr.pos == 0) {
+      ++summary.unmapped;
+      continue;
+    }
+    if (sr.mapq < opts.min_mapq) {
+      ++summary.low_mapq;
+      continue;
+    }
+    if (!opts.multi_mapping &&
+        (check_flag(sr, samflags::secondary_aln) ||
+         check_flag(sr, samflags::supplementary_aln) || get_n_hits(sr) > 1)) {
+      ++summary.multi_mapping;
+      continue;
+    }
+    if (sr.rname != chrom_name) {
+      chrom_name = sr.rname;
+      has_chrom = chrom_dict::find(chrom_name, chrom);
+    }
+    if (!has_chrom) {
+      // no features on this chrom
+      ++summary.no_feature;
+      continue;
+    }
+    const bool rc = check_flag(sr, samflags::read_rc);
+    const bool second = check_flag(sr, samflags::read_paired) &&
+                        check_flag(sr, samflags::template_last);
+    const char strand = (rc != second) ? '-' : '+';
+
+    // each run of the CIGAR not broken by 'N' is a block
+    hits.block.set_chrom_id(chrom);
+    size_t pos = sr.pos - 1, block_start = pos;
+    auto itr = std::begin(sr.cigar);
+    const auto cigar_end = std::end(sr.cigar);
+    while (itr != cigar_end) {
+      const size_t n = extract_op_count(itr, cigar_end);
+      if (itr == cigar_end)
+        break;
+      const char op = *itr++;
+      if (op == 'N') {
+        if (block_start < pos) {
+          hits.block.set_start(block_start);
+          hits.block.set_end(pos);
+          add_block(hits, strand, opts);
+        }
+        block_start = pos + n;
+      }
+      if (consumes_reference(op))
+        pos += n;
+    }
+    if (block_start < pos) {
+      hits.block.set_start(block_start);
+      hits.block.set_end(pos);
+      add_block(hits, strand, opts);
+    }
+    add_read(hits, counts, summary, opts);
+  }
+}
+
+void FeatureCounter::count_range(const vector<MappedRead> &reads,
+                                 const size_t first, const size_t last,
+                                 vector<double> &counts, count_summary &summary,
+                                 const count_options &opts) const {
+  read_hits hits;
+  for (size_t i = first; i < last; ++i) {
+    const GenomicRegion &r = reads[i].r;
+    hits.block.set_chrom_id(r.get_chrom_id());
+    hits.block.set_start(r.get_start());
+    hits.block.set_end(r.get_end());
+    add_block(hits, r.get_strand(), opts);
+    add_read(hits, counts, summary, opts);
+  }
+}
+
+template <class R>
+void FeatureCounter::count_chunks(const vector<R> &reads,
+                                  vector<double> &counts,
+                                  count_summary &summary,
+                                  const count_options &opts,
+                                  const size_t n_threads) const {
+  // small enough that threads finish close together, even when reads in
+  // some parts of the genome take longer, and large enough that taking a
+  // chunk costs little
+  static const size_t chunk_size = 1 << 14;
+  const size_t n_chunks = (reads.size() + chunk_size - 1) / chunk_size;
+  const size_t n_workers = std::max<size_t>(1, std::min(n_threads, n_chunks));
+  vector<vector<double>> worker_counts(n_workers);
+  vector<count_summary> worker_summaries(n_workers);
+  std::atomic<size_t> next_chunk(0);
+  run_tasks(n_workers, n_threads, [&](const size_t w) {
+    // each worker has its own counts, used for every chunk it takes
+    worker_counts[w].resize(names.size());
+    for (size_t c = next_chunk++; c < n_chunks; c = next_chunk++) {
+      const size_t first = c * chunk_size;
+      const size_t last = std::min(reads.size(), first + chunk_size);
+      count_range(reads, first, last, worker_counts[w], worker_summaries[w],
+                  opts);
+    }
+  });
+  counts.clear();
+  counts.resize(names.size());
+  summary = count_summary();
+  for (size_t w = 0; w < n_workers; ++w) {
+    for (size_t i = 0; i < names.size(); ++i)
+      counts[i] += worker_counts[w][i];
+    summary += worker_summaries[w];
+  }
+}
+
+void FeatureCounter::count(const vector<sam_rec> &reads,
+                           vector<double> &counts, count_summary &summary,
+                           const count_options &opts,
+                           const size_t n_threads) const {
+  count_chunks(reads, counts, summary, opts, n_threads);
+}
+
+void FeatureCounter::count(const vector<MappedRead> &reads,
+                           vector<double> &counts, count_summary &summary,
+                           const count_options &opts,
+                           const size_t n_threads) const {
+  count_chunks(reads, counts, summary, opts, n_threads);
+}
@@ -0,0 +1,130 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef FEATURE_COUNTER_HPP
+#define FEATURE_COUNTER_HPP
+
+#include "GenomicRegion.hpp"
+#include "MappedRead.hpp"
+#include "RegionIndex.hpp"
+#include "sam_record.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// which reads can be counted for a feature on a given strand
+enum class count_strand {
+  unstranded, // reads on either strand
+  forward,    // reads on the strand of the feature
+  reverse,    // reads on the other strand, as for dUTP libraries
+};
+
+// what is done with a read that overlaps more than one feature
+enum class count_overlap {
+  unique,   // not counted, but kept as ambiguous in the summary
+  all,      // counted once for each feature
+  fraction, // counted 1/n for each of the n features
+};
+
+struct count_options {
+  count_strand strand{count_strand::unstranded};
+  count_overlap overlap{count_overlap::unique};
+  bool multi_mapping{}; // count reads that map to more than one place
+  uint8_t min_mapq{};
+};
+
+// what happened to each read
+struct count_summary {
+  size_t assigned{};
+  size_t no_feature{};
+  size_t ambiguous{};
+  size_t multi_mapping{};
+  size_t low_mapq{};
+  size_t unmapped{};
+
+  count_summary &operator+=(const count_summary &other);
+};
+
+/* FeatureCounter: counts of reads for each of a set of features, like
+ * genes, exons or promoters, as done by featureCounts. The features are
+ * indexed once, when the counter is made, and can then be used to count
+ * any number of sets of reads. A feature is either one region, or all
+ * the regions with the same name, as for the exons of a gene. A read
+ * counts for a feature if any base it aligns to is in one of the
+ * regions of the feature; for SAM records, the bases skipped by 'N' in
+ * the CIGAR are not part of the read.
+ *
+ * The reads are split into small chunks, which threads take as they
+ * become free. Each thread counts into its own counts, which are added
+ * together at the end. Fractional counts can differ in the last bits
+ * from one run to the next, as the chunks a thread takes vary.
+ */
+class FeatureCounter {
+public:
+  explicit FeatureCounter(const std::vector<GenomicRegion> &regions,
+                          const bool group_by_name = false);
+
+  size_t size() const { return names.size(); }
+  const std::string &get_name(const size_t i) const { return names[i]; }
+
+  /* SAM records that are unmapped, or have a mapq below min_mapq, are not
+   * counted. Secondary and supplementary alignments, and records with an
+   * NH tag above 1, are multi-mapping. For the second read of a pair the
+   * strand is reversed, so both reads of a pair have the strand of the
+   * fragment.
+   */
+  void count(const std::vector<sam_rec> &reads, std::vector<double> &counts,
+             count_summary &summary,
+             const count_options &opts = count_options(),
+             const size_t n_threads = 1) const;
+  void count(const std::vector<MappedRead> &reads,
+             std::vector<double> &counts, count_summary &summary,
+             const count_options &opts = count_options(),
+             const size_t n_threads = 1) const;
+
+private:
+  // scratch space for counting one read
+  struct read_hits {
+    GenomicRegion block;
+    std::vector<size_t> regions;
+    std::vector<size_t> features;
+  };
+
+  // the features of regions overlapping hits.block, on an allowed strand
+  void add_block(read_hits &hits, const char strand,
+                 const count_options &opts) const;
+  // add the read with the features in hits.features to the counts
+  void add_read(read_hits &hits, std::vector<double> &counts,
+                count_summary &summary, const count_options &opts) const;
+  void count_range(const std::vector<sam_rec> &reads, const size_t first,
+                   const size_t last, std::vector<double> &counts,
+                   count_summary &summary, const count_options &opts) const;
+  void count_range(const std::vector<MappedRead> &reads, const size_t first,
+                   const size_t last, std::vector<double> &counts,
+                   count_summary &summary, const count_options &opts) const;
+  template <class R>
+  void count_chunks(const std::vector<R> &reads, std::vector<double> &counts,
+                    count_summary &summary, const count_options &opts,
+                    const size_t n_threads) const;
+
+  RegionIndex<GenomicRegion> index;
+  std::vector<size_t> feature_of; // for each region
+  std::vector<char> strands;      // for each region
+  std::vector<std::string> names; // for each feature
+};
+
+#endif
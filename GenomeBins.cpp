@@ -0,0 +1,160 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "GenomeBins.hpp"
+#include "chrom_tasks.hpp"
+#include "smithlab_os.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::to_string;
+using std::vector;
+
+GenomeBins::GenomeBins(const vector<string> &chrom_names,
+                       const vector<size_t> &chrom_sizes,
+                       const size_t bin_size, const bin_rule rule)
+    : bin_size(bin_size), rule(rule) {
+  if (bin_size == 0)
+    throw runtime_error("bin size must be positive");
+  if (chrom_names.size() != chrom_sizes.size())
+    throw runtime_error("different numbers of chrom names and sizes");
+  for (size_t i = 0; i < chrom_names.size(); ++i) {
+    const chrom_id_type c = chrom_dict::assign(chrom_names[i]);
+    if (chroms.size() <= c)
+      chroms.resize(c + 1);
+    if (!chroms[c].present)
+      ordered.push_back(c);
+    chroms[c].size = chrom_sizes[i];
+    chroms[c].present = true;
+  }
+  std::sort(std::begin(ordered), std::end(ordered), chrom_dict::less);
+  size_t n_bins = 0;
+  for (const auto c : ordered) {
+    chroms[c].offset = n_bins;
+    n_bins += (chroms[c].size + bin_size - 1) / bin_size;
+  }
+  stats.resize(n_bins);
+}
+
+const GenomeBins::chrom_bins &
+GenomeBins::get_chrom_bins(const chrom_id_type chrom) const {
+  if (chrom >= chroms.size() || !chroms[chrom].present)
+    throw runtime_error("chrom not in chrom sizes: " + chrom_dict::name(chrom));
+  return chroms[chrom];
+}
+
+void GenomeBins::add_to(const chrom_bins &cb, const chrom_id_type chrom,
+                        const size_t start, const size_t end,
+                        const double value) {
+  if (end > cb.size || start >= cb.size)
+    throw runtime_error("region past end of chrom: " + chrom_dict::name(chrom) +
+                        ":" + to_string(start) + "-" + to_string(end));
+  const size_t first = start / bin_size;
+  // an empty region is still in the bin with its start
+  const size_t last = (rule == bin_rule::start || end <= start)
+                          ? first
+                          : (end - 1) / bin_size;
+  for (size_t b = first; b <= last; ++b) {
+    bin_stats &s = stats[cb.offset + b];
+    ++s.count;
+    s.sum += value;
+    s.max = std::max(s.max, value);
+  }
+}
+
+void GenomeBins::add(const chrom_id_type chrom, const size_t start,
+                     const size_t end, const double value) {
+  add_to(get_chrom_bins(chrom), chrom, start, end, value);
+}
+
+void GenomeBins::add(const vector<chrom_id_type> &chrom_ids,
+                     const vector<size_t> &starts, const vector<size_t> &ends,
+                     const vector<double> &values, const size_t n_threads) {
+  const size_t n = chrom_ids.size();
+  if (starts.size() != n || ends.size() != n || values.size() != n)
+    throw runtime_error("different numbers of chroms, starts, ends and values");
+  vector<size_t> order;
+  vector<chrom_task> tasks;
+  group_chrom_tasks(chrom_ids, order, tasks);
+  // check every chrom first, so no bins change if one is missing
+  for (const auto &t : tasks)
+    get_chrom_bins(t.chrom);
+  // each chrom has its own bins, so tasks never write to the same bin
+  run_chrom_tasks(tasks, n_threads, [&](const chrom_task &t, const size_t) {
+    const chrom_bins &cb = chroms[t.chrom];
+    for (size_t k = t.first; k < t.last; ++k) {
+      const size_t i = order[k];
+      add_to(cb, t.chrom, starts[i], ends[i], values[i]);
+    }
+  });
+}
+
+void GenomeBins::add(const vector<bedgraph_record> &records,
+                     const size_t n_threads) {
+  vector<chrom_id_type> c(records.size());
+  vector<size_t> s(records.size()), e(records.size());
+  vector<double> v(records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    c[i] = records[i].chrom;
+    s[i] = records[i].start;
+    e[i] = records[i].end;
+    v[i] = records[i].value;
+  }
+  add(c, s, e, v, n_threads);
+}
+
+static double
+get_statistic(const bin_stats &s, const bin_statistic stat) {
+  switch (stat) {
+  case bin_statistic::count:
+    return s.count;
+  case bin_statistic::sum:
+    return s.sum;
+  case bin_statistic::mean:
+    return s.mean();
+  case bin_statistic::max:
+    return s.count == 0 ? 0.0 : s.max;
+  }
+  return 0.0;
+}
+
+bedgraph_record GenomeBins::get_bin(const size_t i,
+                                    const bin_statistic stat) const {
+  // the last chrom whose first bin is at or before i
+  const auto before_chrom = [this](const size_t x, const chrom_id_type c) {
+    return x < chroms[c].offset;
+  };
+  const auto c = std::upper_bound(std::begin(ordered), std::end(ordered), i,
+                                  before_chrom) -
+                 1;
+  const chrom_bins &cb = chroms[*c];
+  const size_t start = (i - cb.offset) * bin_size;
+  return {*c, start, std::min(start + bin_size, cb.size),
+          get_statistic(stats[i], stat)};
+}
+
+void GenomeBins::write(const string &filename,
+                       const bin_statistic stat) const {
+  BedWriter out(filename, has_gz_ext(filename));
+  for (size_t i = 0; i < stats.size(); ++i)
+    if (stats[i].count > 0)
+      out.write(get_bin(i, stat));
+  out.close();
+}
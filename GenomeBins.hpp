@@ -0,0 +1,119 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef GENOME_BINS_HPP
+#define GENOME_BINS_HPP
+
+#include "GenomicRegion.hpp"
+#include "bed_io.hpp"
+#include "chrom_dict.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+// the values added to one bin
+struct bin_stats {
+  size_t count{};
+  double sum{};
+  double max{-std::numeric_limits<double>::infinity()};
+  double mean() const { return count == 0 ? 0.0 : sum / count; }
+};
+
+enum class bin_statistic { count, sum, mean, max };
+
+// which bins a region adds its value to
+enum class bin_rule {
+  start,   // only the bin with its start, as for single sites
+  overlap, // every bin it overlaps
+};
+
+/* GenomeBins: bins of a fixed size tiling the chroms of a chrom sizes
+ * file, with the last bin of each chrom shorter. The bins are never
+ * made as regions: bin i of a chrom is [i*bin_size, (i+1)*bin_size),
+ * and only the statistics of each bin are stored, in chrom_dict order.
+ * Adding a vector groups it by chrom and fills the bins of each chrom
+ * in one pass, with chroms in parallel. Adding from a stream, like a
+ * BedReader, reads it once. Regions on chroms not in the list, or past
+ * the end of a chrom, are errors.
+ */
+class GenomeBins {
+public:
+  GenomeBins(const std::vector<std::string> &chrom_names,
+             const std::vector<size_t> &chrom_sizes, const size_t bin_size,
+             const bin_rule rule = bin_rule::start);
+
+  void add(const chrom_id_type chrom, const size_t start, const size_t end,
+           const double value);
+  void add(const std::vector<chrom_id_type> &chroms,
+           const std::vector<size_t> &starts, const std::vector<size_t> &ends,
+           const std::vector<double> &values, const size_t n_threads = 1);
+  // regions of any type, with their scores as the values
+  template <class T>
+  void add(const std::vector<T> &regions, const size_t n_threads = 1);
+  void add(const std::vector<bedgraph_record> &records,
+           const size_t n_threads = 1);
+  // any stream with bool read(GenomicRegion &), with scores as values
+  template <class S> void add_stream(S &in);
+
+  size_t size() const { return stats.size(); }
+  size_t get_bin_size() const { return bin_size; }
+  const bin_stats &get_stats(const size_t i) const { return stats[i]; }
+  // the place of bin i on the genome, as a record with the statistic
+  bedgraph_record get_bin(const size_t i, const bin_statistic stat) const;
+
+  // write bins with at least one value as bedGraph, gzip if ".gz"
+  void write(const std::string &filename, const bin_statistic stat) const;
+
+private:
+  struct chrom_bins {
+    size_t size{};
+    size_t offset{}; // of the first bin in stats
+    bool present{};
+  };
+
+  const chrom_bins &get_chrom_bins(const chrom_id_type chrom) const;
+  void add_to(const chrom_bins &cb, const chrom_id_type chrom,
+              const size_t start, const size_t end, const double value);
+
+  size_t bin_size;
+  bin_rule rule;
+  std::vector<chrom_bins> chroms;     // indexed by chrom id
+  std::vector<chrom_id_type> ordered; // chroms in the order of their bins
+  std::vector<bin_stats> stats;
+};
+
+template <class T>
+void GenomeBins::add(const std::vector<T> &regions, const size_t n_threads) {
+  std::vector<chrom_id_type> c(regions.size());
+  std::vector<size_t> s(regions.size()), e(regions.size());
+  std::vector<double> v(regions.size());
+  for (size_t i = 0; i < regions.size(); ++i) {
+    c[i] = regions[i].get_chrom_id();
+    s[i] = regions[i].get_start();
+    e[i] = regions[i].get_end();
+    v[i] = regions[i].get_score();
+  }
+  add(c, s, e, v, n_threads);
+}
+
+template <class S> void GenomeBins::add_stream(S &in) {
+  GenomicRegion r;
+  while (in.read(r))
+    add(r.get_chrom_id(), r.get_start(), r.get_end(), r.get_score());
+}
+
+#endif
@@ -0,0 +1,389 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "GenomeMask.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+static const uint64_t genome_mask_magic = 0x4b53414d4e475201ull;
+
+static size_t popcount(const uint64_t w) { return __builtin_popcountll(w); }
+
+// bits [lo, hi) of a word, for 0 <= lo < hi <= 64
+static uint64_t bit_range(const size_t lo, const size_t hi) {
+  const uint64_t upper = (hi == 64) ? ~0ull : (1ull << hi) - 1;
+  return upper & ~((1ull << lo) - 1);
+}
+
+void GenomeMask::set_runs(chrom_mask &m, vector<size_t> &starts,
+                          vector<size_t> &ends) {
+  m.words.clear();
+  m.run_starts.clear();
+  m.run_ends.clear();
+  m.run_before.clear();
+  const size_t n_words = ends.empty() ? 0 : (ends.back() + 63) / 64;
+  // a run costs three values, and a word holds 64 bases
+  m.dense = !ends.empty() && n_words < 3 * starts.size();
+  if (m.dense) {
+    m.words.resize(n_words, 0);
+    for (size_t i = 0; i < starts.size(); ++i) {
+      size_t s = starts[i];
+      const size_t e = ends[i];
+      while (s < e) {
+        const size_t w = s / 64;
+        const size_t hi = std::min(e - w * 64, size_t{64});
+        m.words[w] |= bit_range(s % 64, hi);
+        s = w * 64 + hi;
+      }
+    }
+    starts.clear();
+    ends.clear();
+  }
+  else {
+    m.run_starts.swap(starts);
+    m.run_ends.swap(ends);
+    m.run_before.resize(m.run_starts.size());
+    size_t before = 0;
+    for (size_t i = 0; i < m.run_starts.size(); ++i) {
+      m.run_before[i] = before;
+      before += m.run_ends[i] - m.run_starts[i];
+    }
+  }
+}
+
+void GenomeMask::to_runs(const chrom_mask &m, vector<size_t> &starts,
+                         vector<size_t> &ends) {
+  starts.clear();
+  ends.clear();
+  if (!m.dense) {
+    starts = m.run_starts;
+    ends = m.run_ends;
+    return;
+  }
+  bool in_run = false;
+  for (size_t w = 0; w < m.words.size(); ++w) {
+    // flip the word so the next boundary is always a set bit
+    uint64_t x = in_run ? ~m.words[w] : m.words[w];
+    size_t b = 0;
+    while (b < 64 && (x >> b) != 0) {
+      b += __builtin_ctzll(x >> b);
+      if (in_run)
+        ends.push_back(w * 64 + b);
+      else
+        starts.push_back(w * 64 + b);
+      in_run = !in_run;
+      x = ~x;
+    }
+  }
+  if (in_run)
+    ends.push_back(m.words.size() * 64);
+}
+
+void GenomeMask::build(const vector<chrom_id_type> &chroms,
+                       const vector<size_t> &starts,
+                       const vector<size_t> &ends) {
+  vector<size_t> order(chroms.size());
+  std::iota(std::begin(order), std::end(order), 0);
+  std::sort(std::begin(order), std::end(order),
+            [&](const size_t a, const size_t b) {
+              return chroms[a] < chroms[b] ||
+                     (chroms[a] == chroms[b] && starts[a] < starts[b]);
+            });
+  masks.clear();
+  vector<size_t> run_starts, run_ends;
+  for (size_t i = 0; i < order.size();) {
+    const chrom_id_type c = chroms[order[i]];
+    run_starts.clear();
+    run_ends.clear();
+    for (; i < order.size() && chroms[order[i]] == c; ++i) {
+      const size_t s = starts[order[i]], e = ends[order[i]];
+      if (s >= e)
+        continue;
+      // regions that overlap or touch become one run
+      if (!run_ends.empty() && s <= run_ends.back())
+        run_ends.back() = std::max(run_ends.back(), e);
+      else {
+        run_starts.push_back(s);
+        run_ends.push_back(e);
+      }
+    }
+    if (masks.size() <= c)
+      masks.resize(c + 1);
+    set_runs(masks[c], run_starts, run_ends);
+  }
+}
+
+bool GenomeMask::contains(const chrom_id_type chrom, const size_t pos) const {
+  if (chrom >= masks.size())
+    return false;
+  const chrom_mask &m = masks[chrom];
+  if (m.dense)
+    return pos / 64 < m.words.size() && ((m.words[pos / 64] >> (pos % 64)) & 1);
+  const auto i = std::upper_bound(std::begin(m.run_starts),
+                                  std::end(m.run_starts), pos) -
+                 std::begin(m.run_starts);
+  return i > 0 && pos < m.run_ends[i - 1];
+}
+
+size_t GenomeMask::count(const chrom_id_type chrom, const size_t start,
+                         size_t end) const {
+  if (chrom >= masks.size())
+    return 0;
+  const chrom_mask &m = masks[chrom];
+  if (m.dense) {
+    end = std::min(end, m.words.size() * 64);
+    if (start >= end)
+      return 0;
+    const size_t w0 = start / 64, w1 = (end - 1) / 64;
+    if (w0 == w1)
+      return popcount(m.words[w0] & bit_range(start % 64, end - w1 * 64));
+    size_t total = popcount(m.words[w0] & bit_range(start % 64, 64));
+    for (size_t w = w0 + 1; w < w1; ++w)
+      total += popcount(m.words[w]);
+    return total + popcount(m.words[w1] & bit_range(0, end - w1 * 64));
+  }
+  if (start >= end)
+    return 0;
+  // the covered bases before position x
+  const auto covered_before = [&m](const size_t x) -> size_t {
+    const auto i = std::upper_bound(std::begin(m.run_starts),
+                                    std::end(m.run_starts), x) -
+                   std::begin(m.run_starts);
+    if (i == 0)
+      return 0;
+    return m.run_before[i - 1] + std::min(x, m.run_ends[i - 1]) -
+           m.run_starts[i - 1];
+  };
+  return covered_before(end) - covered_before(start);
+}
+
+size_t GenomeMask::count(const chrom_id_type chrom) const {
+  return count(chrom, 0, std::numeric_limits<size_t>::max());
+}
+
+size_t GenomeMask::count() const {
+  size_t total = 0;
+  for (size_t c = 0; c < masks.size(); ++c)
+    total += count(c);
+  return total;
+}
+
+// the runs covered by a op b, where each input has disjoint sorted runs
+template <class Op>
+static void combine_runs(const vector<size_t> &a_starts,
+                         const vector<size_t> &a_ends,
+                         const vector<size_t> &b_starts,
+                         const vector<size_t> &b_ends, Op op,
+                         vector<size_t> &starts, vector<size_t> &ends) {
+  static const size_t none = std::numeric_limits<size_t>::max();
+  starts.clear();
+  ends.clear();
+  // boundary k of a run list is the start (even k) or end (odd k) of run k/2
+  const auto boundary = [](const vector<size_t> &s, const vector<size_t> &e,
+                           const size_t k) {
+    return (k / 2 >= s.size()) ? none : ((k % 2 == 0) ? s[k / 2] : e[k / 2]);
+  };
+  size_t i = 0, j = 0;
+  bool in = false;
+  while (true) {
+    const size_t next_a = boundary(a_starts, a_ends, i);
+    const size_t next_b = boundary(b_starts, b_ends, j);
+    const size_t pos = std::min(next_a, next_b);
+    if (pos == none)
+      break;
+    if (next_a == pos)
+      ++i;
+    if (next_b == pos)
+      ++j;
+    // after passing k boundaries, a position is covered if k is odd
+    const bool now_in = op(i % 2 == 1, j % 2 == 1);
+    if (now_in && !in)
+      starts.push_back(pos);
+    else if (!now_in && in)
+      ends.push_back(pos);
+    in = now_in;
+  }
+}
+
+void GenomeMask::combine(const GenomeMask &other, const mask_op op) {
+  const size_t n_chroms = std::max(masks.size(), other.masks.size());
+  masks.resize(n_chroms);
+  const chrom_mask empty_mask;
+  vector<size_t> a_starts, a_ends, b_starts, b_ends, starts, ends;
+  for (size_t c = 0; c < n_chroms; ++c) {
+    chrom_mask &a = masks[c];
+    const chrom_mask &b = c < other.masks.size() ? other.masks[c] : empty_mask;
+    if (a.dense && b.dense) {
+      // whole words at a time, then the form is chosen again below
+      const size_t n = b.words.size();
+      if (op == mask_op::unite && a.words.size() < n)
+        a.words.resize(n, 0);
+      if (op == mask_op::intersect && a.words.size() > n)
+        a.words.resize(n);
+      for (size_t w = 0; w < std::min(a.words.size(), n); ++w)
+        a.words[w] = (op == mask_op::unite)       ? a.words[w] | b.words[w]
+                     : (op == mask_op::intersect) ? a.words[w] & b.words[w]
+                                                  : a.words[w] & ~b.words[w];
+      to_runs(a, starts, ends);
+    }
+    else {
+      to_runs(a, a_starts, a_ends);
+      to_runs(b, b_starts, b_ends);
+      combine_runs(a_starts, a_ends, b_starts, b_ends,
+                   [op](const bool x, const bool y) {
+                     return op == mask_op::unite       ? x || y
+                            : op == mask_op::intersect ? x && y
+                                                       : x && !y;
+                   },
+                   starts, ends);
+    }
+    set_runs(a, starts, ends);
+  }
+}
+
+void GenomeMask::unite(const GenomeMask &other) {
+  combine(other, mask_op::unite);
+}
+
+void GenomeMask::intersect(const GenomeMask &other) {
+  combine(other, mask_op::intersect);
+}
+
+void GenomeMask::subtract(const GenomeMask &other) {
+  combine(other, mask_op::subtract);
+}
+
+void GenomeMask::to_regions(vector<SimpleGenomicRegion> &regions) const {
+  vector<chrom_id_type> chroms;
+  for (size_t c = 0; c < masks.size(); ++c)
+    if (masks[c].dense || !masks[c].run_starts.empty())
+      chroms.push_back(c);
+  std::sort(std::begin(chroms), std::end(chroms), chrom_dict::less);
+  regions.clear();
+  vector<size_t> starts, ends;
+  for (const auto c : chroms) {
+    to_runs(masks[c], starts, ends);
+    for (size_t i = 0; i < starts.size(); ++i)
+      regions.push_back(
+          SimpleGenomicRegion(chrom_dict::name(c), starts[i], ends[i]));
+  }
+}
+
+/* The file has the magic number and the number of chroms, then for each
+ * chrom the length of its name, the name, whether it is dense and the
+ * number of words or runs, then the words or the run starts and ends.
+ */
+template <class T>
+static void write_values(std::ofstream &out, const T *values, const size_t n) {
+  out.write(reinterpret_cast<const char *>(values), n * sizeof(T));
+}
+
+template <class T>
+static void read_values(std::ifstream &in, T *values, const size_t n) {
+  in.read(reinterpret_cast<char *>(values), n * sizeof(T));
+}
+
+void GenomeMask::write(const string &filename) const {
+  std::ofstream out(filename, std::ios::binary);
+  if (!out)
+    throw runtime_error("failed to open file " + filename);
+  uint64_t n_chroms = 0;
+  for (const auto &m : masks)
+    n_chroms += (m.dense || !m.run_starts.empty());
+  const uint64_t header[] = {genome_mask_magic, n_chroms};
+  write_values(out, header, 2);
+  for (size_t c = 0; c < masks.size(); ++c) {
+    const chrom_mask &m = masks[c];
+    if (!m.dense && m.run_starts.empty())
+      continue;
+    const string &name = chrom_dict::name(c);
+    const uint64_t sizes[] = {name.size(), m.dense,
+                              m.dense ? m.words.size() : m.run_starts.size()};
+    write_values(out, &sizes[0], 1);
+    write_values(out, name.data(), name.size());
+    write_values(out, &sizes[1], 2);
+    if (m.dense)
+      write_values(out, m.words.data(), m.words.size());
+    else {
+      write_values(out, m.run_starts.data(), m.run_starts.size());
+      write_values(out, m.run_ends.data(), m.run_ends.size());
+    }
+  }
+  if (!out)
+    throw runtime_error("error writing file " + filename);
+}
+
+GenomeMask::GenomeMask(const string &filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in)
+    throw runtime_error("failed to open file " + filename);
+  in.seekg(0, std::ios::end);
+  const uint64_t file_size = in.tellg();
+  in.seekg(0, std::ios::beg);
+  const auto check_size = [&](const uint64_t n, const size_t value_size) {
+    const uint64_t pos = in.tellg();
+    if (!in || n > (file_size - pos) / value_size)
+      throw runtime_error("corrupt genome mask file: " + filename);
+  };
+
+  uint64_t header[2] = {};
+  read_values(in, header, 2);
+  if (!in || header[0] != genome_mask_magic)
+    throw runtime_error("not a genome mask file: " + filename);
+  string name;
+  vector<size_t> starts, ends;
+  for (uint64_t i = 0; i < header[1]; ++i) {
+    uint64_t name_size = 0;
+    read_values(in, &name_size, 1);
+    check_size(name_size, 1);
+    name.resize(name_size);
+    read_values(in, &name[0], name_size);
+    uint64_t form[2] = {};
+    read_values(in, form, 2);
+    check_size(form[1], form[0] ? sizeof(uint64_t) : 2 * sizeof(size_t));
+    const chrom_id_type c = chrom_dict::assign(name);
+    if (masks.size() <= c)
+      masks.resize(c + 1);
+    chrom_mask &m = masks[c];
+    if (form[0]) {
+      m = chrom_mask();
+      m.dense = true;
+      m.words.resize(form[1]);
+      read_values(in, m.words.data(), form[1]);
+    }
+    else {
+      starts.resize(form[1]);
+      ends.resize(form[1]);
+      read_values(in, starts.data(), form[1]);
+      read_values(in, ends.data(), form[1]);
+      for (size_t j = 0; j < starts.size(); ++j)
+        if (starts[j] >= ends[j] || (j > 0 && starts[j] <= ends[j - 1]))
+          throw runtime_error("corrupt genome mask file: " + filename);
+      set_runs(m, starts, ends);
+    }
+  }
+  if (!in)
+    throw runtime_error("corrupt genome mask file: " + filename);
+}
@@ -0,0 +1,98 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef GENOME_MASK_HPP
+#define GENOME_MASK_HPP
+
+#include "GenomicRegion.hpp"
+#include "chrom_dict.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* GenomeMask: the set of bases covered by a set of regions. Each chrom
+ * is kept either as one bit per base, for O(1) membership and counting
+ * 64 bases at a time, or as sorted runs of covered bases, which is much
+ * smaller for sparse sets like blacklists. After the mask is built or
+ * changed, each chrom is kept in whichever form takes less space;
+ * membership in the runs form takes a binary search. Regions are
+ * half-open, [start, end), as in BED.
+ */
+class GenomeMask {
+public:
+  GenomeMask() = default;
+  // the bases covered by any of the regions
+  template <class T> explicit GenomeMask(const std::vector<T> &regions);
+  // read a mask written by write()
+  explicit GenomeMask(const std::string &filename);
+
+  bool contains(const chrom_id_type chrom, const size_t pos) const;
+  template <class T> bool contains(const T &region) const {
+    return contains(region.get_chrom_id(), region.get_start());
+  }
+  // the number of covered bases in [start, end) on chrom
+  size_t count(const chrom_id_type chrom, const size_t start,
+               const size_t end) const;
+  // the number of covered bases on chrom, or in all chroms
+  size_t count(const chrom_id_type chrom) const;
+  size_t count() const;
+
+  // change this mask to the union, intersection or difference with other
+  void unite(const GenomeMask &other);
+  void intersect(const GenomeMask &other);
+  void subtract(const GenomeMask &other);
+
+  // the covered bases as disjoint regions, in chrom_dict order
+  void to_regions(std::vector<SimpleGenomicRegion> &regions) const;
+
+  void write(const std::string &filename) const;
+
+private:
+  struct chrom_mask {
+    bool dense{};
+    std::vector<uint64_t> words;
+    // disjoint, sorted and not touching, with the covered bases before each
+    std::vector<size_t> run_starts;
+    std::vector<size_t> run_ends;
+    std::vector<size_t> run_before;
+  };
+  enum class mask_op { unite, intersect, subtract };
+
+  void build(const std::vector<chrom_id_type> &chroms,
+             const std::vector<size_t> &starts,
+             const std::vector<size_t> &ends);
+  void combine(const GenomeMask &other, const mask_op op);
+  static void to_runs(const chrom_mask &m, std::vector<size_t> &starts,
+                      std::vector<size_t> &ends);
+  static void set_runs(chrom_mask &m, std::vector<size_t> &starts,
+                       std::vector<size_t> &ends);
+
+  std::vector<chrom_mask> masks; // indexed by chrom id
+};
+
+template <class T> GenomeMask::GenomeMask(const std::vector<T> &regions) {
+  std::vector<chrom_id_type> chroms(regions.size());
+  std::vector<size_t> starts(regions.size()), ends(regions.size());
+  for (size_t i = 0; i < regions.size(); ++i) {
+    chroms[i] = regions[i].get_chrom_id();
+    starts[i] = regions[i].get_start();
+    ends[i] = regions[i].get_end();
+  }
+  build(chroms, starts, ends);
+}
+
+#endif
@@ -21,47 +21,30 @@
  */
 
 #include "GenomicRegion.hpp"
+#include "bed_io.hpp"
 #include "smithlab_os.hpp"
 
-#include <cassert>
+#include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 
 using std::ostringstream;
 using std::runtime_error;
 using std::string;
+using std::string_view;
 using std::unordered_map;
 using std::vector;
 
-unordered_map<string, chrom_id_type> SimpleGenomicRegion::fw_table_in;
-unordered_map<chrom_id_type, string> SimpleGenomicRegion::fw_table_out;
-
-chrom_id_type SimpleGenomicRegion::assign_chrom(const std::string &c) {
-  auto chr_id(fw_table_in.find(c));
-  if (chr_id == fw_table_in.end()) {
-    const chrom_id_type r = fw_table_in.size();
-    fw_table_in[c] = r;
-    fw_table_out[r] = c;
-    // return r;
-  }
-  // else return chr_id->second;
-  return fw_table_in[c];
-}
-
-string SimpleGenomicRegion::retrieve_chrom(chrom_id_type i) {
-  auto chr_name(fw_table_out.find(i));
-  // assert(chr_name != fw_table_out.end());
-  return chr_name->second;
-}
-
 SimpleGenomicRegion::SimpleGenomicRegion(const GenomicRegion &r)
-    : chrom(assign_chrom(r.get_chrom())), start(r.get_start()),
-      end(r.get_end()) {}
+    : chrom(r.get_chrom_id()), start(r.get_start()), end(r.get_end()) {}
 
 SimpleGenomicRegion::SimpleGenomicRegion(const char *s, const size_t len) {
   size_t i = 0;
@@ -72,7 +55,7 @@ SimpleGenomicRegion::SimpleGenomicRegion(const char *s, const size_t len) {
   size_t j = i;
   while (!isspace(s[i]) && i < len)
     ++i;
-  chrom = assign_chrom(string(s + j, i - j));
+  chrom = chrom_dict::assign(string_view(s + j, i - j));
 
   // start of the region (a positive integer)
   while (isspace(s[i]) && i < len)
@@ -93,7 +76,7 @@ SimpleGenomicRegion::SimpleGenomicRegion(const char *s, const size_t len) {
 
 string SimpleGenomicRegion::tostring() const {
   std::ostringstream s;
-  s << retrieve_chrom(chrom) << "\t" << start << "\t" << end;
+  s << chrom_dict::name(chrom) << "\t" << start << "\t" << end;
   return s.str();
 }
 
@@ -117,13 +100,13 @@ size_t SimpleGenomicRegion::distance(const SimpleGenomicRegion &other) const {
 }
 
 bool SimpleGenomicRegion::operator<(const SimpleGenomicRegion &rhs) const {
-  return (get_chrom() < rhs.get_chrom() ||
+  return (chrom_dict::less(chrom, rhs.chrom) ||
           (chrom == rhs.chrom &&
            (start < rhs.start || (start == rhs.start && (end < rhs.end)))));
 }
 
 bool SimpleGenomicRegion::less1(const SimpleGenomicRegion &rhs) const {
-  return (get_chrom() < rhs.get_chrom() ||
+  return (chrom_dict::less(chrom, rhs.chrom) ||
           (chrom == rhs.chrom &&
            (end < rhs.end || (end == rhs.end && start < rhs.start))));
 }
@@ -140,28 +123,6 @@ bool SimpleGenomicRegion::operator!=(const SimpleGenomicRegion &rhs) const {
   return (chrom != rhs.chrom || start != rhs.start || end != rhs.end);
 }
 
-unordered_map<string, chrom_id_type> GenomicRegion::fw_table_in;
-unordered_map<chrom_id_type, string> GenomicRegion::fw_table_out;
-
-chrom_id_type GenomicRegion::assign_chrom(const std::string &c) {
-  auto chr_id(fw_table_in.find(c));
-  if (chr_id == fw_table_in.end()) {
-    const chrom_id_type r = fw_table_in.size();
-    fw_table_in[c] = r;
-    fw_table_out[r] = c;
-    return r;
-  }
-  else
-    return chr_id->second;
-}
-
-string GenomicRegion::retrieve_chrom(chrom_id_type i) {
-  unordered_map<chrom_id_type, string>::const_iterator chr_name(
-      fw_table_out.find(i));
-  assert(chr_name != fw_table_out.end());
-  return chr_name->second;
-}
-
 GenomicRegion::GenomicRegion(const char *s, const size_t len) {
   size_t i = 0;
 
@@ -185,7 +146,7 @@ GenomicRegion::GenomicRegion(const char *s, const size_t len) {
         "(a properly formatted BED file must contain at least three):\n" +
         string(s));
 
-  chrom = assign_chrom(string(s + j, i - j));
+  chrom = chrom_dict::assign(string_view(s + j, i - j));
 
   // start of the region (a positive integer)
   while (isspace(s[i]) && i < len)
@@ -235,7 +196,7 @@ GenomicRegion::GenomicRegion(const char *s, const size_t len) {
 
 string GenomicRegion::tostring() const {
   std::ostringstream s;
-  s << retrieve_chrom(chrom) << "\t" << start << "\t" << end;
+  s << chrom_dict::name(chrom) << "\t" << start << "\t" << end;
   if (!name.empty())
     s << "\t" << name << "\t" << score << "\t" << strand;
   return s.str();
@@ -268,7 +229,7 @@ bool GenomicRegion::operator<(const GenomicRegion &rhs) const {
                                 (strand < rhs.strand
                                  // || (strand == rhs.strand && name < rhs.name)
                                  )))))) ||
-          get_chrom() < rhs.get_chrom());
+          chrom_dict::less(chrom, rhs.chrom));
 }
 
 bool GenomicRegion::less1(const GenomicRegion &rhs) const {
@@ -279,7 +240,7 @@ bool GenomicRegion::less1(const GenomicRegion &rhs) const {
                                 (strand < rhs.strand
                                  // || (strand == rhs.strand && name < rhs.name)
                                  )))))) ||
-          get_chrom() < rhs.get_chrom());
+          chrom_dict::less(chrom, rhs.chrom));
 }
 
 bool GenomicRegion::operator<=(const GenomicRegion &rhs) const {
@@ -299,34 +260,46 @@ bool GenomicRegion::operator!=(const GenomicRegion &rhs) const {
 void separate_chromosomes(
     const vector<SimpleGenomicRegion> &regions,
     vector<vector<SimpleGenomicRegion>> &separated_by_chrom) {
-  typedef unordered_map<chrom_id_type, vector<SimpleGenomicRegion>> Separator;
-  Separator separator;
-  for (vector<SimpleGenomicRegion>::const_iterator i = regions.begin();
-       i != regions.end(); ++i) {
-    const chrom_id_type the_chrom(i->chrom);
-    if (separator.find(the_chrom) == separator.end())
-      separator[the_chrom] = vector<SimpleGenomicRegion>();
-    separator[the_chrom].push_back(*i);
+  // chroms are given in chrom_dict order, not the order of a hash table
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  vector<chrom_id_type> chroms;
+  unordered_map<chrom_id_type, vector<SimpleGenomicRegion>> separator;
+  for (const auto &r : regions) {
+    auto &v = separator[r.chrom];
+    if (v.empty())
+      chroms.push_back(r.chrom);
+    v.push_back(r);
   }
+  std::sort(std::begin(chroms), std::end(chroms),
+            [&ranks](const chrom_id_type a, const chrom_id_type b) {
+              return ranks[a] < ranks[b];
+            });
   separated_by_chrom.clear();
-  for (Separator::iterator i = separator.begin(); i != separator.end(); ++i)
-    separated_by_chrom.push_back(i->second);
+  for (const auto c : chroms)
+    separated_by_chrom.push_back(std::move(separator[c]));
 }
 
 void separate_chromosomes(const vector<GenomicRegion> &regions,
                           vector<vector<GenomicRegion>> &separated_by_chrom) {
-  typedef unordered_map<chrom_id_type, vector<GenomicRegion>> Separator;
-  Separator separator;
-  for (vector<GenomicRegion>::const_iterator i = regions.begin();
-       i != regions.end(); ++i) {
-    const chrom_id_type the_chrom(i->chrom);
-    if (separator.find(the_chrom) == separator.end())
-      separator[the_chrom] = vector<GenomicRegion>();
-    separator[the_chrom].push_back(*i);
+  // chroms are given in chrom_dict order, not the order of a hash table
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  vector<chrom_id_type> chroms;
+  unordered_map<chrom_id_type, vector<GenomicRegion>> separator;
+  for (const auto &r : regions) {
+    auto &v = separator[r.chrom];
+    if (v.empty())
+      chroms.push_back(r.chrom);
+    v.push_back(r);
   }
+  std::sort(std::begin(chroms), std::end(chroms),
+            [&ranks](const chrom_id_type a, const chrom_id_type b) {
+              return ranks[a] < ranks[b];
+            });
   separated_by_chrom.clear();
-  for (Separator::iterator i = separator.begin(); i != separator.end(); ++i)
-    separated_by_chrom.push_back(i->second);
+  for (const auto c : chroms)
+    separated_by_chrom.push_back(std::move(separator[c]));
 }
 
 static inline auto is_header_line(const string &line) -> bool {
@@ -348,14 +321,7 @@ static inline auto is_track_line(const string &line) -> bool {
 }
 
 void ReadBEDFile(const string &filename, vector<GenomicRegion> &the_regions) {
-  std::ifstream in(filename);
-  if (!in)
-    throw runtime_error("failed to open file " + filename);
-
-  string line;
-  while (getline(in, line))
-    if (!is_header_line(line) && !is_track_line(line))
-      the_regions.push_back(GenomicRegion(line));
+  read_bed_file(filename, the_regions);
 }
 
 void ReadBEDFile(const string &filename,
@@ -372,3 +338,49 @@ void ReadBEDFile(const string &filename,
     if (!is_header_line(line) && !is_track_line(line))
       the_regions.push_back(SimpleGenomicRegion(line));
 }
+
+static void write_track_line(BedWriter &out, const string &track_name) {
+  if (!track_name.empty())
+    out.write("track name=" + track_name + "\n");
+}
+
+void WriteBEDFile(const string &filename, const vector<GenomicRegion> &regions,
+                  const string &track_name) {
+  BedWriter out(filename);
+  write_track_line(out, track_name);
+  for (const auto &r : regions)
+    out.write(r);
+  out.close();
+}
+
+void WriteBEDFile(const string &filename,
+                  const vector<vector<GenomicRegion>> &regions,
+                  const string &track_name) {
+  BedWriter out(filename);
+  write_track_line(out, track_name);
+  for (const auto &v : regions)
+    for (const auto &r : v)
+      out.write(r);
+  out.close();
+}
+
+void WriteBEDFile(const string &filename,
+                  const vector<SimpleGenomicRegion> &regions,
+                  const string &track_name) {
+  BedWriter out(filename);
+  write_track_line(out, track_name);
+  for (const auto &r : regions)
+    out.write(r);
+  out.close();
+}
+
+void WriteBEDFile(const string &filename,
+                  const vector<vector<SimpleGenomicRegion>> &regions,
+                  const string &track_name) {
+  BedWriter out(filename);
+  write_track_line(out, track_name);
+  for (const auto &v : regions)
+    for (const auto &r : v)
+      out.write(r);
+  out.close();
+}
@@ -24,23 +24,25 @@
 #ifndef GENOMIC_REGION_HPP
 #define GENOMIC_REGION_HPP
 
+#include "chrom_dict.hpp"
 #include "smithlab_utils.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iterator>
 #include <stdio.h>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 class GenomicRegion;
 
-typedef unsigned chrom_id_type;
-
 class SimpleGenomicRegion {
 public:
-  SimpleGenomicRegion() : chrom(assign_chrom("(null)")), start(0), end(0) {}
+  SimpleGenomicRegion()
+      : chrom(chrom_dict::assign("(null)")), start(0), end(0) {}
   void swap(SimpleGenomicRegion &rhs) {
     std::swap(chrom, rhs.chrom);
     std::swap(start, rhs.start);
@@ -49,7 +51,7 @@ public:
 
   // Other constructors
   SimpleGenomicRegion(std::string c, size_t sta, size_t e)
-      : chrom(assign_chrom(c)), start(sta), end(e) {}
+      : chrom(chrom_dict::assign(c)), start(sta), end(e) {}
   SimpleGenomicRegion(const GenomicRegion &rhs);
   SimpleGenomicRegion(const char *string_representation, const size_t len);
   explicit SimpleGenomicRegion(const std::string &line)
@@ -58,15 +60,18 @@ public:
   std::string tostring() const;
 
   // accessors
-  std::string get_chrom() const { return retrieve_chrom(chrom); }
+  const std::string &get_chrom() const { return chrom_dict::name(chrom); }
+  chrom_id_type get_chrom_id() const { return chrom; }
   size_t get_start() const { return start; }
   size_t get_end() const { return end; }
   size_t get_width() const { return (end > start) ? end - start : 0; }
 
   // mutators
   void set_chrom(const std::string &new_chrom) {
-    chrom = assign_chrom(new_chrom);
+    chrom = chrom_dict::assign(new_chrom);
   }
+  // the id must come from chrom_dict
+  void set_chrom_id(chrom_id_type c) { chrom = c; }
   void set_start(size_t new_start) { start = new_start; }
   void set_end(size_t new_end) { end = new_end; }
 
@@ -89,13 +94,6 @@ public:
       std::vector<std::vector<SimpleGenomicRegion>> &separated_by_chrom);
 
 private:
-  static chrom_id_type assign_chrom(const std::string &c);
-  static std::string retrieve_chrom(chrom_id_type i);
-
-  static std::unordered_map<std::string, chrom_id_type> fw_table_in;
-  static std::unordered_map<chrom_id_type, std::string> fw_table_out;
-
-  // std::string chrom;
   chrom_id_type chrom;
   size_t start;
   size_t end;
@@ -117,8 +115,8 @@ template <class T> T &operator<<(T &the_stream, const SimpleGenomicRegion &r) {
 class GenomicRegion {
 public:
   GenomicRegion()
-      : chrom(assign_chrom("(NULL)")), name("X"), start(0), end(0), score(0),
-        strand('+') {}
+      : chrom(chrom_dict::assign("(NULL)")), name("X"), start(0), end(0),
+        score(0), strand('+') {}
   void swap(GenomicRegion &rhs) {
     std::swap(chrom, rhs.chrom);
     std::swap(name, rhs.name);
@@ -131,25 +129,30 @@ public:
   // Other constructors
   GenomicRegion(std::string c, size_t sta, size_t e, std::string n, float sc,
                 char str)
-      : chrom(assign_chrom(c)), name(n), start(sta), end(e), score(sc),
+      : chrom(chrom_dict::assign(c)), name(n), start(sta), end(e), score(sc),
         strand(str) {}
+  // the id must come from chrom_dict
+  GenomicRegion(const chrom_id_type c, const size_t sta, const size_t e,
+                const std::string_view n, const float sc, const char str)
+      : chrom(c), name(n), start(sta), end(e), score(sc), strand(str) {}
   GenomicRegion(std::string c, size_t sta, size_t e)
-      : chrom(assign_chrom(c)), name(std::string("X")), start(sta), end(e),
-        score(0.0), strand('+') {}
+      : chrom(chrom_dict::assign(c)), name(std::string("X")), start(sta),
+        end(e), score(0.0), strand('+') {}
   GenomicRegion(const char *s, const size_t len);
   explicit GenomicRegion(const std::string &line)
       : GenomicRegion(line.c_str(), line.length()) {}
   GenomicRegion(const SimpleGenomicRegion &other)
-      : chrom(assign_chrom(other.get_chrom())), name("(NULL)"),
+      : chrom(other.get_chrom_id()), name("(NULL)"),
         start(other.get_start()), end(other.get_end()), score(0), strand('+') {}
   std::string tostring() const;
 
   // accessors
-  std::string get_chrom() const { return retrieve_chrom(chrom); }
+  const std::string &get_chrom() const { return chrom_dict::name(chrom); }
+  chrom_id_type get_chrom_id() const { return chrom; }
   size_t get_start() const { return start; }
   size_t get_end() const { return end; }
   size_t get_width() const { return (end > start) ? end - start : 0; }
-  std::string get_name() const { return name; }
+  const std::string &get_name() const { return name; }
   float get_score() const { return score; }
   char get_strand() const { return strand; }
   bool pos_strand() const { return (strand == '+'); }
@@ -157,13 +160,15 @@ public:
 
   // mutators
   void set_chrom(const std::string &new_chrom) {
-    chrom = assign_chrom(new_chrom);
+    chrom = chrom_dict::assign(new_chrom);
   }
   void set_start(size_t new_start) { start = new_start; }
   void set_end(size_t new_end) { end = new_end; }
-  void set_name(const std::string &n) { name = n; }
+  void set_name(const std::string_view n) { name = n; }
   void set_score(float s) { score = s; }
   void set_strand(char s) { strand = s; }
+  // the id must come from chrom_dict
+  void set_chrom_id(chrom_id_type c) { chrom = c; }
 
   // comparison functions
   bool contains(const GenomicRegion &other) const;
@@ -184,13 +189,6 @@ public:
       std::vector<std::vector<GenomicRegion>> &separated_by_chrom);
 
 private:
-  static chrom_id_type assign_chrom(const std::string &c);
-  static std::string retrieve_chrom(chrom_id_type i);
-
-  static std::unordered_map<std::string, chrom_id_type> fw_table_in;
-  static std::unordered_map<chrom_id_type, std::string> fw_table_out;
-
-  // std::string chrom;
   chrom_id_type chrom;
   std::string name;
   size_t start;
@@ -247,21 +245,108 @@ void separate_regions(const std::vector<T> &big_regions,
   const size_t n_big_regions = big_regions.size();
   sep_regions.resize(n_big_regions);
   for (size_t i = 0; i < n_big_regions; ++i) {
-    const std::string current_chrom(big_regions[i].get_chrom());
+    const chrom_id_type current_chrom = big_regions[i].get_chrom_id();
     const size_t current_start = big_regions[i].get_start();
     const size_t current_end = big_regions[i].get_end();
-    while (rr_id < n_regions && (regions[rr_id].get_chrom() < current_chrom ||
-                                 (regions[rr_id].get_chrom() == current_chrom &&
-                                  regions[rr_id].get_start() < current_start)))
+    while (rr_id < n_regions &&
+           (chrom_dict::less(regions[rr_id].get_chrom_id(), current_chrom) ||
+            (regions[rr_id].get_chrom_id() == current_chrom &&
+             regions[rr_id].get_start() < current_start)))
       ++rr_id;
-    while (rr_id < n_regions && (regions[rr_id].get_chrom() == current_chrom &&
-                                 regions[rr_id].get_start() < current_end)) {
+    while (rr_id < n_regions &&
+           (regions[rr_id].get_chrom_id() == current_chrom &&
+            regions[rr_id].get_start() < current_end)) {
       sep_regions[i].push_back(regions[rr_id]);
       ++rr_id;
     }
   }
 }
 
+/* chrom_span: the regions of one chrom, as a range of a vector that is
+ * not copied. Spans are only valid while that vector is not changed.
+ */
+template <class T> class chrom_span {
+public:
+  typedef const T *const_iterator;
+  chrom_span() = default;
+  chrom_span(const chrom_id_type c, const T *f, const T *l)
+      : chrom(c), first(f), last(l) {}
+
+  chrom_id_type get_chrom_id() const { return chrom; }
+  const std::string &get_chrom() const { return chrom_dict::name(chrom); }
+  const_iterator begin() const { return first; }
+  const_iterator end() const { return last; }
+  size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+  const T &operator[](const size_t i) const { return first[i]; }
+  const T &front() const { return *first; }
+  const T &back() const { return *(last - 1); }
+
+private:
+  chrom_id_type chrom{};
+  const T *first{};
+  const T *last{};
+};
+
+/* The same groups as separate_chromosomes, in chrom_dict order, but as
+ * spans. If the regions of each chrom are together, as they are when
+ * the regions are sorted, the spans are of the regions and nothing is
+ * copied. Otherwise the regions are copied once into storage, grouped
+ * by chrom and keeping their order within each chrom, and the spans
+ * are of the storage. Returns true if the regions were copied.
+ */
+template <class T>
+bool get_chrom_spans(const std::vector<T> &regions,
+                     std::vector<chrom_span<T>> &spans,
+                     std::vector<T> &storage) {
+  spans.clear();
+  storage.clear();
+  std::vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  // find the runs of each chrom, reading only the chrom ids
+  std::vector<bool> seen(ranks.size(), false);
+  std::vector<size_t> run_starts;
+  bool grouped = true;
+  for (size_t i = 0; i < regions.size() && grouped; ++i) {
+    const chrom_id_type c = regions[i].get_chrom_id();
+    if (i == 0 || c != regions[i - 1].get_chrom_id()) {
+      grouped = !seen[c];
+      seen[c] = true;
+      run_starts.push_back(i);
+    }
+  }
+  const std::vector<T> *grouped_regions = &regions;
+  if (!grouped) {
+    // a stable counting sort by chrom id
+    std::vector<size_t> offsets(ranks.size() + 1, 0);
+    for (const auto &r : regions)
+      ++offsets[r.get_chrom_id() + 1];
+    for (size_t c = 1; c < offsets.size(); ++c)
+      offsets[c] += offsets[c - 1];
+    std::vector<size_t> order(regions.size());
+    for (size_t i = 0; i < regions.size(); ++i)
+      order[offsets[regions[i].get_chrom_id()]++] = i;
+    storage.reserve(regions.size());
+    for (const auto i : order)
+      storage.push_back(regions[i]);
+    run_starts.clear();
+    for (size_t i = 0; i < storage.size(); ++i)
+      if (i == 0 || storage[i].get_chrom_id() != storage[i - 1].get_chrom_id())
+        run_starts.push_back(i);
+    grouped_regions = &storage;
+  }
+  const T *data = grouped_regions->data();
+  run_starts.push_back(grouped_regions->size());
+  for (size_t k = 0; k + 1 < run_starts.size(); ++k)
+    spans.emplace_back(data[run_starts[k]].get_chrom_id(),
+                       data + run_starts[k], data + run_starts[k + 1]);
+  std::sort(std::begin(spans), std::end(spans),
+            [&ranks](const chrom_span<T> &a, const chrom_span<T> &b) {
+              return ranks[a.get_chrom_id()] < ranks[b.get_chrom_id()];
+            });
+  return !grouped;
+}
+
 template <class T> bool check_sorted(const std::vector<T> &regions) {
   for (size_t i = 1; i < regions.size(); ++i)
     if (regions[i] < regions[i - 1])
@@ -397,6 +482,20 @@ void WriteBEDFile(const std::string filename, const std::vector<T> &regions,
   out.close();
 }
 
+// for regions these use BedWriter, and write the same text as the above
+void WriteBEDFile(const std::string &filename,
+                  const std::vector<GenomicRegion> &regions,
+                  const std::string &track_name = "");
+void WriteBEDFile(const std::string &filename,
+                  const std::vector<std::vector<GenomicRegion>> &regions,
+                  const std::string &track_name = "");
+void WriteBEDFile(const std::string &filename,
+                  const std::vector<SimpleGenomicRegion> &regions,
+                  const std::string &track_name = "");
+void WriteBEDFile(const std::string &filename,
+                  const std::vector<std::vector<SimpleGenomicRegion>> &regions,
+                  const std::string &track_name = "");
+
 template <class T> std::string assemble_region_name(const T &region) {
   return (region.get_chrom() + ":" + smithlab::toa(region.get_start()) + "-" +
           smithlab::toa(region.get_end()));
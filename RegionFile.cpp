@@ -0,0 +1,425 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "RegionFile.hpp"
+#include "bed_io.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::pair;
+using std::runtime_error;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::unordered_map;
+using std::vector;
+
+// version 2 then "SLRGNFL"; it reads differently in the other byte order
+static const uint64_t region_file_magic = 0x4c464e47524c5302ull;
+
+struct region_file_header {
+  uint64_t magic;
+  uint64_t n_regions;
+  uint64_t n_chroms;
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint64_t file_size;
+  // offsets of each part from the start of the file
+  uint64_t chrom_name_offsets;
+  uint64_t chrom_names;
+  uint64_t chrom_index;
+  uint64_t start_bases;
+  uint64_t start_offsets;
+  uint64_t widths;
+  uint64_t scores;
+  uint64_t strands;
+  uint64_t name_offsets;
+  uint64_t names;
+  uint64_t n_wide;
+  uint64_t wide_rows;
+  uint64_t wide_ends;
+};
+
+static size_t n_start_blocks(const size_t n_regions) {
+  return (n_regions + (1ul << RegionFile::block_bits) - 1) >>
+         RegionFile::block_bits;
+}
+
+static size_t region_file_padding(const size_t offset) {
+  return (8 - offset % 8) % 8;
+}
+
+// checks that [offset, offset + n_bytes) is inside the file
+static void check_part(const region_file_header &h, const uint64_t offset,
+                       const uint64_t n_bytes, const string &filename) {
+  if (offset > h.file_size || n_bytes > h.file_size - offset || offset % 8)
+    throw runtime_error("corrupt region file: " + filename);
+}
+
+// checks that the n + 1 offsets never decrease
+static void check_offsets(const uint64_t *offsets, const size_t n,
+                          const string &filename) {
+  for (size_t i = 0; i < n; ++i)
+    if (offsets[i + 1] < offsets[i])
+      throw runtime_error("corrupt region file: " + filename);
+}
+
+RegionFile::RegionFile(const string &filename) : file(filename) {
+  load(file.data(), file.size(), filename);
+}
+
+void RegionFile::load(const char *data, const size_t data_size,
+                      const string &filename) {
+  region_file_header h;
+  if (data_size < sizeof(h))
+    throw runtime_error("not a region file: " + filename);
+  std::memcpy(&h, data, sizeof(h));
+  if (h.magic != region_file_magic)
+    throw runtime_error("not a region file, or from a different machine "
+                        "type: " +
+                        filename);
+  if (h.file_size != data_size)
+    throw runtime_error("incomplete region file: " + filename);
+  // every row and chrom takes at least one byte in the file
+  if (h.n_regions > h.file_size || h.n_chroms > h.file_size)
+    throw runtime_error("corrupt region file: " + filename);
+
+  n_regions = h.n_regions;
+  source_size = h.source_size;
+  source_mtime = h.source_mtime;
+
+  check_part(h, h.chrom_name_offsets, (h.n_chroms + 1) * sizeof(uint64_t),
+             filename);
+  const uint64_t *chrom_name_offsets =
+      reinterpret_cast<const uint64_t *>(data + h.chrom_name_offsets);
+  check_offsets(chrom_name_offsets, h.n_chroms, filename);
+  check_part(h, h.chrom_names, chrom_name_offsets[h.n_chroms], filename);
+  const char *chrom_names = data + h.chrom_names;
+  chrom_ids.resize(h.n_chroms);
+  for (size_t i = 0; i < h.n_chroms; ++i)
+    chrom_ids[i] = chrom_dict::assign(
+        string_view(chrom_names + chrom_name_offsets[i],
+                    chrom_name_offsets[i + 1] - chrom_name_offsets[i]));
+
+  check_part(h, h.chrom_index, n_regions * sizeof(uint32_t), filename);
+  check_part(h, h.start_bases, n_start_blocks(n_regions) * sizeof(uint64_t),
+             filename);
+  check_part(h, h.start_offsets, n_regions * sizeof(uint32_t), filename);
+  check_part(h, h.widths, n_regions * sizeof(uint32_t), filename);
+  check_part(h, h.scores, n_regions * sizeof(float), filename);
+  check_part(h, h.strands, n_regions, filename);
+  check_part(h, h.name_offsets, (n_regions + 1) * sizeof(uint64_t), filename);
+  chrom_index = reinterpret_cast<const uint32_t *>(data + h.chrom_index);
+  start_bases = reinterpret_cast<const uint64_t *>(data + h.start_bases);
+  start_offsets = reinterpret_cast<const uint32_t *>(data + h.start_offsets);
+  widths = reinterpret_cast<const uint32_t *>(data + h.widths);
+  scores = reinterpret_cast<const float *>(data + h.scores);
+  strands = data + h.strands;
+  name_offsets = reinterpret_cast<const uint64_t *>(data + h.name_offsets);
+  for (size_t i = 0; i < n_regions; ++i)
+    if (chrom_index[i] >= h.n_chroms)
+      throw runtime_error("corrupt region file: " + filename);
+  check_offsets(name_offsets, n_regions, filename);
+  check_part(h, h.names, name_offsets[n_regions], filename);
+  names = data + h.names;
+
+  // the wide rows, in order, are those with the width that marks them
+  if (h.n_wide > n_regions)
+    throw runtime_error("corrupt region file: " + filename);
+  n_wide = h.n_wide;
+  check_part(h, h.wide_rows, n_wide * sizeof(uint64_t), filename);
+  check_part(h, h.wide_ends, n_wide * sizeof(uint64_t), filename);
+  wide_rows = reinterpret_cast<const uint64_t *>(data + h.wide_rows);
+  wide_ends = reinterpret_cast<const uint64_t *>(data + h.wide_ends);
+  size_t n_marked = 0;
+  for (size_t i = 0; i < n_regions; ++i)
+    if (widths[i] == wide_width) {
+      if (n_marked == n_wide || wide_rows[n_marked] != i)
+        throw runtime_error("corrupt region file: " + filename);
+      ++n_marked;
+    }
+  if (n_marked != n_wide)
+    throw runtime_error("corrupt region file: " + filename);
+}
+
+size_t RegionFile::get_wide_end(const size_t i) const {
+  return wide_ends[std::lower_bound(wide_rows, wide_rows + n_wide, i) -
+                   wide_rows];
+}
+
+GenomicRegion RegionFile::get_region(const size_t i) const {
+  return GenomicRegion(get_chrom_id(i), get_start(i), get_end(i), get_name(i),
+                       get_score(i), get_strand(i));
+}
+
+void RegionFile::to_table(RegionTable &regions) const {
+  regions.clear();
+  regions.reserve(n_regions, name_offsets[n_regions]);
+  for (size_t i = 0; i < n_regions; ++i)
+    regions.push_back(get_chrom_id(i), get_start(i), get_end(i), get_name(i),
+                      get_score(i), get_strand(i));
+}
+
+void RegionFile::to_regions(vector<GenomicRegion> &regions) const {
+  regions.clear();
+  regions.reserve(n_regions);
+  for (size_t i = 0; i < n_regions; ++i)
+    regions.push_back(get_region(i));
+}
+
+// writes a region file into memory, in place of an ofstream
+struct region_file_buffer {
+  vector<char> &data;
+  size_t pos{};
+  void write(const char *p, const size_t n) {
+    if (pos + n > data.size())
+      data.resize(pos + n);
+    std::copy_n(p, n, std::begin(data) + pos);
+    pos += n;
+  }
+  void seekp(const size_t p) { pos = p; }
+};
+
+// appends a part to the file and gives its offset
+template <class Out, class T>
+static uint64_t write_part(Out &out, uint64_t &offset, const vector<T> &part) {
+  static const char zeros[8] = {};
+  const size_t padding = region_file_padding(offset);
+  out.write(zeros, padding);
+  offset += padding;
+  const uint64_t part_offset = offset;
+  out.write(reinterpret_cast<const char *>(part.data()),
+            part.size() * sizeof(T));
+  offset += part.size() * sizeof(T);
+  return part_offset;
+}
+
+template <class Out>
+static void write_region_parts(Out &out, const RegionTable &regions,
+                               const uint64_t source_size,
+                               const int64_t source_mtime) {
+  static const size_t max_offset = std::numeric_limits<uint32_t>::max();
+  static const size_t wide_width = RegionFile::wide_width;
+  const size_t n_regions = regions.size();
+
+  // the chroms, numbered in the order they first appear
+  unordered_map<chrom_id_type, uint32_t> chrom_index_of;
+  vector<uint32_t> chrom_index(n_regions);
+  vector<char> chrom_names;
+  vector<uint64_t> chrom_name_offsets(1, 0);
+  for (size_t i = 0; i < n_regions; ++i) {
+    const chrom_id_type c = regions.get_chrom_id(i);
+    auto it = chrom_index_of.find(c);
+    if (it == std::end(chrom_index_of)) {
+      it = chrom_index_of.emplace(c, chrom_index_of.size()).first;
+      const string &name = chrom_dict::name(c);
+      chrom_names.insert(std::end(chrom_names), std::begin(name),
+                         std::end(name));
+      chrom_name_offsets.push_back(chrom_names.size());
+    }
+    chrom_index[i] = it->second;
+  }
+
+  const size_t block_size = 1ul << RegionFile::block_bits;
+  vector<uint64_t> start_bases(n_start_blocks(n_regions));
+  vector<uint32_t> start_offsets(n_regions);
+  vector<uint32_t> widths(n_regions);
+  vector<uint64_t> wide_rows, wide_ends;
+  for (size_t b = 0; b < start_bases.size(); ++b) {
+    const size_t first = b * block_size;
+    const size_t last = std::min(n_regions, first + block_size);
+    size_t base = regions.get_start(first);
+    for (size_t i = first + 1; i < last; ++i)
+      base = std::min(base, regions.get_start(i));
+    start_bases[b] = base;
+    for (size_t i = first; i < last; ++i) {
+      const size_t start = regions.get_start(i), end = regions.get_end(i);
+      if (start - base > max_offset)
+        throw runtime_error("starts too far apart for region file near "
+                            "row " +
+                            to_string(i));
+      start_offsets[i] = start - base;
+      if (end < start || end - start >= wide_width) {
+        widths[i] = wide_width;
+        wide_rows.push_back(i);
+        wide_ends.push_back(end);
+      }
+      else
+        widths[i] = end - start;
+    }
+  }
+
+  vector<char> names;
+  vector<uint64_t> name_offsets(1, 0);
+  name_offsets.reserve(n_regions + 1);
+  for (size_t i = 0; i < n_regions; ++i) {
+    const string_view name = regions.get_name(i);
+    names.insert(std::end(names), std::begin(name), std::end(name));
+    name_offsets.push_back(names.size());
+  }
+
+  region_file_header h{};
+  h.magic = region_file_magic;
+  h.n_regions = n_regions;
+  h.n_chroms = chrom_name_offsets.size() - 1;
+  h.source_size = source_size;
+  h.source_mtime = source_mtime;
+  // the header is written again once the offsets are known
+  out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+  uint64_t offset = sizeof(h);
+  h.chrom_name_offsets = write_part(out, offset, chrom_name_offsets);
+  h.chrom_names = write_part(out, offset, chrom_names);
+  h.chrom_index = write_part(out, offset, chrom_index);
+  h.start_bases = write_part(out, offset, start_bases);
+  h.start_offsets = write_part(out, offset, start_offsets);
+  h.widths = write_part(out, offset, widths);
+  h.scores = write_part(out, offset, regions.get_scores());
+  h.strands = write_part(out, offset, regions.get_strands());
+  h.name_offsets = write_part(out, offset, name_offsets);
+  h.names = write_part(out, offset, names);
+  h.n_wide = wide_rows.size();
+  h.wide_rows = write_part(out, offset, wide_rows);
+  h.wide_ends = write_part(out, offset, wide_ends);
+  h.file_size = offset;
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+}
+
+static void write_region_file(const string &filename,
+                              const RegionTable &regions,
+                              const uint64_t source_size,
+                              const int64_t source_mtime) {
+  std::ofstream out(filename, std::ios::binary);
+  if (!out)
+    throw runtime_error("failed to open file " + filename);
+  write_region_parts(out, regions, source_size, source_mtime);
+  out.close();
+  if (!out)
+    throw runtime_error("error writing file " + filename);
+}
+
+RegionFile::RegionFile(const RegionTable &regions, const uint64_t source_size,
+                       const int64_t source_mtime) {
+  region_file_buffer out{buffer};
+  write_region_parts(out, regions, source_size, source_mtime);
+  load(buffer.data(), buffer.size(), "regions in memory");
+}
+
+void write_region_file(const string &filename, const RegionTable &regions) {
+  write_region_file(filename, regions, 0, 0);
+}
+
+static void get_source_stamp(const string &filename, uint64_t &size,
+                             int64_t &mtime) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  size = fs::file_size(filename, ec);
+  if (ec)
+    throw runtime_error("failed to open file " + filename);
+  mtime = fs::last_write_time(filename, ec).time_since_epoch().count();
+  if (ec)
+    throw runtime_error("failed to open file " + filename);
+}
+
+void convert_bed_to_region_file(const string &bed_filename,
+                                const string &region_filename,
+                                const size_t n_threads) {
+  uint64_t source_size = 0;
+  int64_t source_mtime = 0;
+  get_source_stamp(bed_filename, source_size, source_mtime);
+  RegionTable regions;
+  read_bed_file(bed_filename, regions, n_threads);
+  write_region_file(region_filename, regions, source_size, source_mtime);
+}
+
+RegionFile load_bed_cached(const string &bed_filename,
+                           const size_t n_threads) {
+  const string cache_filename = bed_filename + ".rgn";
+  uint64_t source_size = 0;
+  int64_t source_mtime = 0;
+  get_source_stamp(bed_filename, source_size, source_mtime);
+  try {
+    RegionFile cached(cache_filename);
+    if (cached.get_source_size() == source_size &&
+        cached.get_source_mtime() == source_mtime)
+      return cached;
+  }
+  catch (const runtime_error &) {
+    // missing or unreadable, so made again below
+  }
+  RegionTable regions;
+  read_bed_file(bed_filename, regions, n_threads);
+  // a name no other process or thread can take, in the same directory
+  // so the rename is atomic
+  string tmp_filename = cache_filename + ".tmpXXXXXX";
+  const int fd = mkstemp(&tmp_filename[0]);
+  bool written = fd >= 0;
+  if (written) {
+    // mkstemp makes a file only the owner can read
+    fchmod(fd, 0644);
+    close(fd);
+    try {
+      write_region_file(tmp_filename, regions, source_size, source_mtime);
+    }
+    catch (const runtime_error &) {
+      written = false;
+    }
+  }
+  if (!written ||
+      std::rename(tmp_filename.c_str(), cache_filename.c_str()) != 0) {
+    // no cache, as in a read-only directory, so keep it in memory
+    if (fd >= 0)
+      std::remove(tmp_filename.c_str());
+    return RegionFile(regions, source_size, source_mtime);
+  }
+  return RegionFile(cache_filename);
+}
+
+bool check_sorted(const RegionFile &regions) {
+  return table_check_sorted(regions);
+}
+
+void collapse(const RegionFile &regions, RegionTable &collapsed) {
+  table_collapse(regions, collapsed);
+}
+
+void separate_regions(const RegionFile &big_regions, const RegionFile &regions,
+                      vector<pair<size_t, size_t>> &sep_regions) {
+  table_separate_regions(big_regions, regions, sep_regions);
+}
+
+void genomic_region_intersection(const RegionFile &regions_a,
+                                 const RegionFile &regions_b,
+                                 RegionTable &regions_c) {
+  table_intersection(regions_a, regions_b, regions_c);
+}
+
+void genomic_region_intersection_by_base(const RegionFile &regions_a,
+                                         const RegionFile &regions_b,
+                                         RegionTable &regions_c) {
+  table_intersection_by_base(regions_a, regions_b, regions_c);
+}
@@ -0,0 +1,157 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef REGION_FILE_HPP
+#define REGION_FILE_HPP
+
+#include "GenomicRegion.hpp"
+#include "RegionTable.hpp"
+#include "smithlab_os.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* RegionFile: a set of regions saved in a binary file by column, and
+ * read back by mapping the file into memory, so opening a file costs
+ * almost nothing no matter how many regions it has. The rows are read
+ * in place, with the same accessors as RegionTable, so the table_*
+ * algorithms in RegionTable.hpp work on a RegionFile directly.
+ *
+ * The file holds, each part aligned to 8 bytes:
+ *  - a header with counts and the offset of each part;
+ *  - the chrom names, and for each row the index of its chrom name;
+ *  - starts in blocks of 64 rows: a 64-bit base for each block, and for
+ *    each row a 32-bit offset from the base of its block;
+ *  - 32-bit widths (end - start), float scores and char strands;
+ *  - 64-bit offsets into the names, which are stored together;
+ *  - for the rows with a width of 2^32 - 1 or more, or that end before
+ *    they start, which have wide_width in place of a width, the row
+ *    numbers in order and their 64-bit ends.
+ * Numbers are in the byte order of the machine that wrote the file, and
+ * files from a machine with the other order are rejected on opening.
+ */
+class RegionFile {
+public:
+  explicit RegionFile(const std::string &filename);
+  // the same layout built in memory, for when no file can be written
+  explicit RegionFile(const RegionTable &regions,
+                      const uint64_t source_size = 0,
+                      const int64_t source_mtime = 0);
+
+  size_t size() const { return n_regions; }
+  bool empty() const { return n_regions == 0; }
+
+  chrom_id_type get_chrom_id(const size_t i) const {
+    return chrom_ids[chrom_index[i]];
+  }
+  const std::string &get_chrom(const size_t i) const {
+    return chrom_dict::name(get_chrom_id(i));
+  }
+  size_t get_start(const size_t i) const {
+    return start_bases[i >> block_bits] + start_offsets[i];
+  }
+  size_t get_end(const size_t i) const {
+    return widths[i] == wide_width ? get_wide_end(i) : get_start(i) + widths[i];
+  }
+  std::string_view get_name(const size_t i) const {
+    return std::string_view(names + name_offsets[i],
+                            name_offsets[i + 1] - name_offsets[i]);
+  }
+  float get_score(const size_t i) const { return scores[i]; }
+  char get_strand(const size_t i) const { return strands[i]; }
+
+  GenomicRegion get_region(const size_t i) const;
+  void to_table(RegionTable &regions) const;
+  void to_regions(std::vector<GenomicRegion> &regions) const;
+
+  // size and modification time of the file the regions came from, if any
+  uint64_t get_source_size() const { return source_size; }
+  int64_t get_source_mtime() const { return source_mtime; }
+
+  static const size_t block_bits = 6;
+  // the width kept for rows whose ends are kept apart
+  static const uint32_t wide_width = std::numeric_limits<uint32_t>::max();
+
+private:
+  size_t get_wide_end(const size_t i) const;
+  void load(const char *data, const size_t data_size,
+            const std::string &filename);
+
+  MappedFile file;
+  std::vector<char> buffer; // the regions when not read from a file
+  size_t n_regions;
+  uint64_t source_size;
+  int64_t source_mtime;
+  std::vector<chrom_id_type> chrom_ids; // index in the file to chrom_dict id
+  const uint32_t *chrom_index;
+  const uint64_t *start_bases;
+  const uint32_t *start_offsets;
+  const uint32_t *widths;
+  const float *scores;
+  const char *strands;
+  const uint64_t *name_offsets;
+  const char *names;
+  size_t n_wide;
+  const uint64_t *wide_rows;
+  const uint64_t *wide_ends;
+};
+
+/* Write regions to a file that RegionFile can open. Starts within each
+ * block of 64 rows must differ by less than 2^32.
+ */
+void write_region_file(const std::string &filename,
+                       const RegionTable &regions);
+
+/* Make a region file from a BED file, which can be compressed with gzip.
+ * The size and time of the BED file are kept in the region file.
+ */
+void convert_bed_to_region_file(const std::string &bed_filename,
+                                const std::string &region_filename,
+                                const size_t n_threads = 1);
+
+/* The regions of a BED file, from a cache next to it named by adding
+ * ".rgn" to the name. The cache is made from the BED file when it is
+ * missing, or when the size or time of the BED file differ from those
+ * kept in the cache. A new cache is written under another name and then
+ * renamed, so jobs running at the same time never see part of a file.
+ * If the cache cannot be written, as in a read-only directory, the
+ * regions are kept in memory instead.
+ */
+RegionFile load_bed_cached(const std::string &bed_filename,
+                           const size_t n_threads = 1);
+
+// versions of the functions in GenomicRegion.hpp for region files
+bool check_sorted(const RegionFile &regions);
+
+void collapse(const RegionFile &regions, RegionTable &collapsed);
+
+void separate_regions(const RegionFile &big_regions,
+                      const RegionFile &regions,
+                      std::vector<std::pair<size_t, size_t>> &sep_regions);
+
+void genomic_region_intersection(const RegionFile &regions_a,
+                                 const RegionFile &regions_b,
+                                 RegionTable &regions_c);
+
+void genomic_region_intersection_by_base(const RegionFile &regions_a,
+                                         const RegionFile &regions_b,
+                                         RegionTable &regions_c);
+
+#endif
@@ -0,0 +1,215 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef REGION_INDEX_HPP
+#define REGION_INDEX_HPP
+
+#include "GenomicRegion.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* RegionIndex: a static interval index over a vector of regions (e.g.,
+ * GenomicRegion or SimpleGenomicRegion). Within each chromosome the
+ * intervals are sorted by start and laid out as an implicit binary tree
+ * (the node at index i has level equal to the number of trailing 1 bits
+ * in i) augmented with the maximum end in each subtree. Queries take
+ * O(log n + k) time for k hits, and report positions in the vector used
+ * to build the index. The index does not refer back to that vector, and
+ * all queries are const, so many threads can query one index at once.
+ *
+ * Overlap has the same meaning as GenomicRegion::overlaps, with the
+ * indexed region as the object and the query as the argument.
+ */
+template <class T> class RegionIndex {
+public:
+  RegionIndex() = default;
+  explicit RegionIndex(const std::vector<T> &regions);
+
+  // positions (in the original vector) of all regions overlapping query,
+  // ordered by start position
+  void overlapping(const T &query, std::vector<size_t> &hits) const;
+  size_t count_overlapping(const T &query) const;
+
+  size_t size() const { return nodes.size(); }
+  bool empty() const { return nodes.empty(); }
+
+private:
+  struct node {
+    size_t start;
+    size_t end;
+    size_t max_end;
+    size_t idx;
+  };
+  struct chrom_block {
+    size_t offset;
+    size_t n;
+    size_t max_level;
+  };
+
+  static bool overlaps(const node &a, const size_t q_start,
+                       const size_t q_end) {
+    // mirrors GenomicRegion::overlaps, including for empty intervals
+    return (a.start < q_end && q_end <= a.end) ||
+           (a.start <= q_start && q_start < a.end) ||
+           (q_start <= a.start && a.end <= q_end);
+  }
+
+  static size_t build_levels(node *a, const size_t n);
+
+  template <class F>
+  void for_each_overlap(const chrom_id_type chrom, const size_t q_start,
+                        const size_t q_end, F f) const;
+
+  std::vector<node> nodes;
+  std::vector<chrom_block> blocks; // indexed by chrom id
+};
+
+template <class T>
+RegionIndex<T>::RegionIndex(const std::vector<T> &regions) {
+  const size_t n_regions = regions.size();
+  std::vector<chrom_id_type> chroms(n_regions);
+  chrom_id_type max_chrom = 0;
+  nodes.resize(n_regions);
+  for (size_t i = 0; i < n_regions; ++i) {
+    const T &r = regions[i];
+    nodes[i] = {r.get_start(), r.get_end(), r.get_end(), i};
+    chroms[i] = r.get_chrom_id();
+    max_chrom = std::max(max_chrom, chroms[i]);
+  }
+
+  // group the nodes by chrom, then sort each group by start
+  std::vector<size_t> counts(n_regions > 0 ? max_chrom + 1 : 0, 0);
+  for (size_t i = 0; i < n_regions; ++i)
+    ++counts[chroms[i]];
+  blocks.resize(counts.size());
+  size_t offset = 0;
+  for (size_t c = 0; c < counts.size(); ++c) {
+    blocks[c] = {offset, counts[c], 0};
+    offset += counts[c];
+  }
+  std::vector<node> grouped(n_regions);
+  std::vector<size_t> fill(counts.size(), 0);
+  for (size_t i = 0; i < n_regions; ++i) {
+    const chrom_block &b = blocks[chroms[i]];
+    grouped[b.offset + fill[chroms[i]]++] = nodes[i];
+  }
+  nodes.swap(grouped);
+
+  for (auto &b : blocks) {
+    const auto first = std::begin(nodes) + b.offset;
+    std::sort(first, first + b.n, [](const node &x, const node &y) {
+      return x.start < y.start || (x.start == y.start && x.idx < y.idx);
+    });
+    b.max_level = build_levels(nodes.data() + b.offset, b.n);
+  }
+}
+
+template <class T>
+size_t RegionIndex<T>::build_levels(node *a, const size_t n) {
+  if (n == 0)
+    return 0;
+  // leaves are at even indices; "last" tracks the max end of the subtree
+  // holding the final node, which may lack a parent inside [0, n)
+  size_t last_i = 0, last = 0;
+  for (size_t i = 0; i < n; i += 2) {
+    last_i = i;
+    last = a[i].max_end = a[i].end;
+  }
+  size_t k = 1;
+  for (; (static_cast<size_t>(1) << k) <= n; ++k) {
+    const size_t x = static_cast<size_t>(1) << (k - 1);
+    const size_t i0 = (x << 1) - 1;
+    const size_t step = x << 2;
+    for (size_t i = i0; i < n; i += step) {
+      const size_t left_end = a[i - x].max_end;
+      const size_t right_end = (i + x < n) ? a[i + x].max_end : last;
+      a[i].max_end = std::max(a[i].end, std::max(left_end, right_end));
+    }
+    last_i = ((last_i >> k) & 1) ? last_i - x : last_i + x;
+    if (last_i < n && a[last_i].max_end > last)
+      last = a[last_i].max_end;
+  }
+  return k - 1;
+}
+
+template <class T>
+template <class F>
+void RegionIndex<T>::for_each_overlap(const chrom_id_type chrom,
+                                      const size_t q_start, const size_t q_end,
+                                      F f) const {
+  if (chrom >= blocks.size() || blocks[chrom].n == 0)
+    return;
+  const chrom_block &b = blocks[chrom];
+  const node *a = nodes.data() + b.offset;
+  const size_t n = b.n;
+
+  // subtrees this small are scanned linearly
+  static const size_t min_level = 3;
+  struct frame {
+    size_t level;
+    size_t x;
+    bool left_done;
+  };
+  // each level adds at most two frames
+  frame stack[2 * 64 + 2];
+  size_t t = 0;
+  stack[t++] = {b.max_level, (static_cast<size_t>(1) << b.max_level) - 1,
+                false};
+  while (t > 0) {
+    const frame z = stack[--t];
+    if (z.level <= min_level) {
+      const size_t i0 = (z.x >> z.level) << z.level;
+      const size_t i1 =
+          std::min(n, i0 + (static_cast<size_t>(1) << (z.level + 1)) - 1);
+      for (size_t i = i0; i < i1 && a[i].start <= q_end; ++i)
+        if (overlaps(a[i], q_start, q_end))
+          f(a[i].idx);
+    }
+    else if (!z.left_done) {
+      const size_t y = z.x - (static_cast<size_t>(1) << (z.level - 1));
+      stack[t++] = {z.level, z.x, true};
+      // the left child may be beyond n but still have descendants in range
+      if (y >= n || a[y].max_end >= q_start)
+        stack[t++] = {z.level - 1, y, false};
+    }
+    else if (z.x < n && a[z.x].start <= q_end) {
+      if (overlaps(a[z.x], q_start, q_end))
+        f(a[z.x].idx);
+      stack[t++] = {z.level - 1,
+                    z.x + (static_cast<size_t>(1) << (z.level - 1)), false};
+    }
+  }
+}
+
+template <class T>
+void RegionIndex<T>::overlapping(const T &query,
+                                 std::vector<size_t> &hits) const {
+  hits.clear();
+  for_each_overlap(query.get_chrom_id(), query.get_start(), query.get_end(),
+                   [&hits](const size_t idx) { hits.push_back(idx); });
+}
+
+template <class T>
+size_t RegionIndex<T>::count_overlapping(const T &query) const {
+  size_t count = 0;
+  for_each_overlap(query.get_chrom_id(), query.get_start(), query.get_end(),
+                   [&count](const size_t) { ++count; });
+  return count;
+}
+
+#endif
@@ -0,0 +1,172 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "RegionSearch.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::vector;
+
+void RegionSearch::build(const vector<chrom_id_type> &chroms,
+                         const vector<size_t> &region_starts,
+                         const vector<size_t> &region_ends) {
+  static const size_t no_key = std::numeric_limits<size_t>::max();
+  const size_t n_regions = chroms.size();
+  chrom_id_type max_chrom = 0;
+  for (const auto c : chroms)
+    max_chrom = std::max(max_chrom, c);
+
+  // group by chrom, then sort each group by start
+  vector<size_t> counts(n_regions > 0 ? max_chrom + 1 : 0, 0);
+  for (const auto c : chroms)
+    ++counts[c];
+  blocks.resize(counts.size());
+  size_t offset = 0;
+  for (size_t c = 0; c < counts.size(); ++c) {
+    blocks[c] = {offset, counts[c], 0, 0, 0};
+    offset += counts[c];
+  }
+  entries.resize(n_regions);
+  vector<size_t> fill(counts.size(), 0);
+  for (size_t i = 0; i < n_regions; ++i)
+    entries[blocks[chroms[i]].offset + fill[chroms[i]]++] = {
+        region_starts[i], region_ends[i], 0, i};
+
+  max_ends.resize(n_regions);
+  for (auto &b : blocks) {
+    entry *first = entries.data() + b.offset;
+    std::sort(first, first + b.n, [](const entry &x, const entry &y) {
+      return x.start < y.start || (x.start == y.start && x.idx < y.idx);
+    });
+    size_t max_end = 0;
+    for (size_t i = 0; i < b.n; ++i) {
+      first[i].max_end = max_end = std::max(max_end, first[i].end);
+      max_ends[b.offset + i] = max_end;
+    }
+    if (b.n == 0)
+      continue;
+    b.max_start = first[b.n - 1].start;
+    b.first_level = level_offsets.size();
+    // each level holds the largest key of each node of the one below
+    vector<size_t> keys(b.n);
+    for (size_t i = 0; i < b.n; ++i)
+      keys[i] = first[i].start;
+    do {
+      level_offsets.push_back(nodes.size());
+      const size_t n_nodes = (keys.size() + node_size - 1) / node_size;
+      vector<size_t> max_keys(n_nodes);
+      for (size_t k = 0; k < n_nodes; ++k) {
+        search_node v;
+        for (size_t j = 0; j < node_size; ++j) {
+          const size_t i = k * node_size + j;
+          v.key[j] = i < keys.size() ? keys[i] : no_key;
+        }
+        max_keys[k] = keys[std::min(keys.size(), (k + 1) * node_size) - 1];
+        nodes.push_back(v);
+      }
+      keys.swap(max_keys);
+    } while (keys.size() > 1);
+    b.n_levels = level_offsets.size() - b.first_level;
+  }
+}
+
+size_t RegionSearch::search(const chrom_block &b, const size_t pos,
+                           const bool near_entries) const {
+  if (b.n == 0 || pos > b.max_start)
+    return b.n;
+  // each node has the answer below it, so no node past the end is read
+  size_t k = 0;
+  for (size_t l = b.n_levels; l-- > 0;) {
+    const search_node &v = nodes[level_offsets[b.first_level + l] + k];
+    if (l == 0) {
+      // ranks from k * node_size - 1 to (k + 1) * node_size - 1
+      const size_t lo = std::max<size_t>(k * node_size, 1) - 1;
+      const size_t hi = std::min(b.n, (k + 1) * node_size) - 1;
+      if (near_entries)
+        for (size_t i = lo; i <= hi + 1 && i < b.n; i += 2)
+          __builtin_prefetch(entries.data() + b.offset + i);
+      else {
+        __builtin_prefetch(max_ends.data() + b.offset + lo);
+        __builtin_prefetch(max_ends.data() + b.offset + hi);
+      }
+    }
+    size_t n_less = 0;
+    for (size_t j = 0; j < node_size; ++j)
+      n_less += (v.key[j] < pos);
+    k = k * node_size + n_less;
+  }
+  return k;
+}
+
+bool RegionSearch::contains(const chrom_id_type chrom, const size_t pos) const {
+  if (chrom >= blocks.size() || blocks[chrom].n == 0)
+    return false;
+  const chrom_block &b = blocks[chrom];
+  // the regions starting at or before pos are those of lower rank
+  const size_t r = search(b, pos + 1, false);
+  return r > 0 && max_ends[b.offset + r - 1] > pos;
+}
+
+size_t RegionSearch::closest(const chrom_id_type chrom, const size_t start,
+                             const size_t end) const {
+  if (chrom >= blocks.size() || blocks[chrom].n == 0)
+    return none;
+  const chrom_block &b = blocks[chrom];
+  const auto distance = [&](const entry &e) -> size_t {
+    if (e.end <= start)
+      return start - e.end + 1;
+    if (end <= e.start)
+      return e.start - end + 1;
+    return 0;
+  };
+  const size_t p = b.offset + search(b, start, true);
+  const size_t chrom_end = b.offset + b.n;
+  pair<size_t, size_t> best(none, none);
+  // to the right, the first region is nearest, unless it is empty and at
+  // start, when a later one may overlap
+  for (size_t i = p; i < chrom_end && best.first != 0; ++i) {
+    best = std::min(best, pair<size_t, size_t>(distance(entries[i]), i));
+    if (entries[i].start >= end || entries[i].start != start)
+      break;
+  }
+  // to the left, the distance depends only on the end, so the nearest is
+  // the first to reach the largest end, or the first to pass start; it is
+  // found by steps that double back from p, as it is usually near
+  if (p > b.offset) {
+    const size_t min_end = std::min(entries[p - 1].max_end, start + 1);
+    size_t lo = b.offset, hi = p - 1; // entries[hi] reaches min_end
+    for (size_t step = 1; hi > lo; step *= 2) {
+      const size_t i = hi - std::min(step, hi - lo);
+      if (entries[i].max_end < min_end) {
+        lo = i + 1;
+        break;
+      }
+      hi = i;
+    }
+    while (lo < hi) {
+      const size_t mid = lo + (hi - lo) / 2;
+      if (entries[mid].max_end < min_end)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    best = std::min(best, pair<size_t, size_t>(distance(entries[hi]), hi));
+  }
+  return entries[best.second].idx;
+}
@@ -0,0 +1,133 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef REGION_SEARCH_HPP
+#define REGION_SEARCH_HPP
+
+#include "chrom_dict.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+/* RegionSearch: a static structure for many point lookups in a set of
+ * regions that does not change. Within each chrom the region starts are
+ * sorted and stored as the leaves of a B+ tree whose nodes are each one
+ * cache line of 8 keys. A node above holds the largest key of each of 8
+ * nodes below it, so a search reads one cache line per level, about a
+ * third as many as a binary search, and ends at the rank of the first
+ * start at or after the position. The regions and the largest end so far
+ * at each rank are prefetched while the leaf is read, so a membership
+ * test or a search for the closest region costs little more than the
+ * search itself. The original
+ * vector does not need to be sorted, and is not referred to after
+ * construction. All queries are const.
+ */
+class RegionSearch {
+public:
+  static const size_t none = std::numeric_limits<size_t>::max();
+
+  RegionSearch() = default;
+  template <class T> explicit RegionSearch(const std::vector<T> &regions);
+
+  // true if some region has start <= pos < end on this chrom
+  bool contains(const chrom_id_type chrom, const size_t pos) const;
+  bool contains(const std::string &chrom, const size_t pos) const {
+    chrom_id_type id = 0;
+    return chrom_dict::find(chrom, id) && contains(id, pos);
+  }
+
+  /* The position in the original vector of the region nearest to
+   * [start, end) on chrom, or none if the chrom has no regions. Distance
+   * is as in GenomicRegion::distance, and ties go to the region with the
+   * smaller start. Unlike find_closest on a vector, regions that are long
+   * enough to reach past their neighbours are also found. Each search
+   * takes O(log n) steps.
+   */
+  size_t closest(const chrom_id_type chrom, const size_t start,
+                 const size_t end) const;
+  template <class T> size_t closest(const T &query) const {
+    return closest(query.get_chrom_id(), query.get_start(), query.get_end());
+  }
+
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  static const size_t node_size = 8;
+
+private:
+  struct chrom_block {
+    size_t offset; // into entries
+    size_t n;
+    size_t max_start;
+    size_t first_level; // into level_offsets, with the leaves first
+    size_t n_levels;
+  };
+  struct alignas(64) search_node {
+    size_t key[node_size];
+  };
+  // a region, in sorted order of start
+  struct entry {
+    size_t start;
+    size_t end;
+    size_t max_end; // the largest end up to here in the chrom
+    size_t idx;
+  };
+
+  void build(const std::vector<chrom_id_type> &chroms,
+             const std::vector<size_t> &region_starts,
+             const std::vector<size_t> &region_ends);
+  /* The rank on the chrom of the first start that is at least pos. The
+   * data read next is prefetched while the leaf is read: the entries
+   * around the rank if near_entries, otherwise the ends before it.
+   */
+  size_t search(const chrom_block &b, const size_t pos,
+                const bool near_entries) const;
+
+  std::vector<chrom_block> blocks; // indexed by chrom id
+  std::vector<search_node> nodes;
+  std::vector<size_t> level_offsets; // into nodes
+  std::vector<entry> entries;
+  // the max_end of the entries, apart so a membership test reads less
+  std::vector<size_t> max_ends;
+};
+
+template <class T> RegionSearch::RegionSearch(const std::vector<T> &regions) {
+  std::vector<chrom_id_type> chroms(regions.size());
+  std::vector<size_t> region_starts(regions.size());
+  std::vector<size_t> region_ends(regions.size());
+  for (size_t i = 0; i < regions.size(); ++i) {
+    chroms[i] = regions[i].get_chrom_id();
+    region_starts[i] = regions[i].get_start();
+    region_ends[i] = regions[i].get_end();
+  }
+  build(chroms, region_starts, region_ends);
+}
+
+/* find_closest through a RegionSearch made from targets: the target
+ * nearest to query on its chrom, or the end of targets if there is none.
+ * The targets don't have to be sorted.
+ */
+template <class T>
+typename std::vector<T>::const_iterator
+find_closest(const std::vector<T> &targets, const RegionSearch &search,
+             const T &query) {
+  const size_t i = search.closest(query);
+  return i == RegionSearch::none ? std::end(targets)
+                                 : std::begin(targets) + i;
+}
+
+#endif
@@ -0,0 +1,204 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "RegionTable.hpp"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::string;
+using std::string_view;
+using std::vector;
+
+RegionTable::RegionTable(const vector<GenomicRegion> &regions)
+    : name_offsets(1, 0) {
+  reserve(regions.size());
+  for (const auto &r : regions)
+    push_back(r);
+}
+
+void RegionTable::to_regions(vector<GenomicRegion> &regions) const {
+  regions.clear();
+  regions.reserve(size());
+  GenomicRegion r;
+  for (size_t i = 0; i < size(); ++i) {
+    r.set_chrom_id(chrom_ids[i]);
+    r.set_start(starts[i]);
+    r.set_end(ends[i]);
+    r.set_name(get_name(i));
+    r.set_score(scores[i]);
+    r.set_strand(strands[i]);
+    regions.push_back(r);
+  }
+}
+
+void RegionTable::clear() {
+  chrom_ids.clear();
+  starts.clear();
+  ends.clear();
+  scores.clear();
+  strands.clear();
+  names.clear();
+  name_offsets.resize(1);
+}
+
+void RegionTable::reserve(const size_t n_regions, const size_t name_bytes) {
+  chrom_ids.reserve(n_regions);
+  starts.reserve(n_regions);
+  ends.reserve(n_regions);
+  scores.reserve(n_regions);
+  strands.reserve(n_regions);
+  names.reserve(name_bytes);
+  name_offsets.reserve(n_regions + 1);
+}
+
+void RegionTable::push_back(const GenomicRegion &r) {
+  push_back(r.get_chrom_id(), r.get_start(), r.get_end(), r.get_name(),
+            r.get_score(), r.get_strand());
+}
+
+void RegionTable::push_back(const chrom_id_type chrom, const size_t start,
+                            const size_t end, const string_view name,
+                            const float score, const char strand) {
+  chrom_ids.push_back(chrom);
+  starts.push_back(start);
+  ends.push_back(end);
+  scores.push_back(score);
+  strands.push_back(strand);
+  names.append(name);
+  name_offsets.push_back(names.size());
+}
+
+void RegionTable::append(const RegionTable &other) {
+  if (&other == this) {
+    const RegionTable copy(other);
+    append(copy);
+    return;
+  }
+  const size_t name_shift = names.size();
+  chrom_ids.insert(std::end(chrom_ids), std::begin(other.chrom_ids),
+                   std::end(other.chrom_ids));
+  starts.insert(std::end(starts), std::begin(other.starts),
+                std::end(other.starts));
+  ends.insert(std::end(ends), std::begin(other.ends), std::end(other.ends));
+  scores.insert(std::end(scores), std::begin(other.scores),
+                std::end(other.scores));
+  strands.insert(std::end(strands), std::begin(other.strands),
+                 std::end(other.strands));
+  names.append(other.names);
+  // the first offset of other is 0, which is already the last one here
+  for (size_t i = 1; i < other.name_offsets.size(); ++i)
+    name_offsets.push_back(other.name_offsets[i] + name_shift);
+}
+
+GenomicRegion RegionTable::get_region(const size_t i) const {
+  GenomicRegion r;
+  r.set_chrom_id(chrom_ids[i]);
+  r.set_start(starts[i]);
+  r.set_end(ends[i]);
+  r.set_name(get_name(i));
+  r.set_score(scores[i]);
+  r.set_strand(strands[i]);
+  return r;
+}
+
+bool RegionTable::row_less(const size_t i, const RegionTable &other,
+                           const size_t j) const {
+  return table_row_less(*this, i, other, j);
+}
+
+bool RegionTable::row_less1(const size_t i, const RegionTable &other,
+                            const size_t j) const {
+  return table_row_less1(*this, i, other, j);
+}
+
+bool RegionTable::row_overlaps(const size_t i, const RegionTable &other,
+                               const size_t j) const {
+  return table_row_overlaps(*this, i, other, j);
+}
+
+void RegionTable::keep_rows(const vector<size_t> &rows) {
+  const size_t n_kept = rows.size();
+  size_t name_end = 0;
+  for (size_t i = 0; i < n_kept; ++i) {
+    const size_t r = rows[i];
+    chrom_ids[i] = chrom_ids[r];
+    starts[i] = starts[r];
+    ends[i] = ends[r];
+    scores[i] = scores[r];
+    strands[i] = strands[r];
+    // rows only move toward the front, so the names can be moved in place
+    const size_t name_begin = name_offsets[r];
+    const size_t name_size = name_offsets[r + 1] - name_begin;
+    std::copy_n(std::begin(names) + name_begin, name_size,
+                std::begin(names) + name_end);
+    name_offsets[i] = name_end;
+    name_end += name_size;
+  }
+  chrom_ids.resize(n_kept);
+  starts.resize(n_kept);
+  ends.resize(n_kept);
+  scores.resize(n_kept);
+  strands.resize(n_kept);
+  names.resize(name_end);
+  name_offsets.resize(n_kept + 1);
+  name_offsets[n_kept] = name_end;
+}
+
+void collapse(RegionTable &regions) {
+  if (regions.empty())
+    return;
+  // only the chrom, start and end columns are read while merging
+  vector<size_t> kept(1, 0);
+  size_t good = 0;
+  for (size_t i = 1; i < regions.size(); ++i)
+    if (regions.row_overlaps(i, regions, good)) {
+      const size_t s = std::min(regions.get_start(i), regions.get_start(good));
+      const size_t e = std::max(regions.get_end(i), regions.get_end(good));
+      regions.set_start(good, s);
+      regions.set_end(good, e);
+    }
+    else {
+      good = i;
+      kept.push_back(i);
+    }
+  regions.keep_rows(kept);
+}
+
+bool check_sorted(const RegionTable &regions) {
+  return table_check_sorted(regions);
+}
+
+void separate_regions(const RegionTable &big_regions,
+                      const RegionTable &regions,
+                      vector<pair<size_t, size_t>> &sep_regions) {
+  table_separate_regions(big_regions, regions, sep_regions);
+}
+
+void genomic_region_intersection(const RegionTable &regions_a,
+                                 const RegionTable &regions_b,
+                                 RegionTable &regions_c) {
+  table_intersection(regions_a, regions_b, regions_c);
+}
+
+void genomic_region_intersection_by_base(const RegionTable &regions_a,
+                                         const RegionTable &regions_b,
+                                         RegionTable &regions_c) {
+  table_intersection_by_base(regions_a, regions_b, regions_c);
+}
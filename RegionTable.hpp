@@ -0,0 +1,269 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef REGION_TABLE_HPP
+#define REGION_TABLE_HPP
+
+#include "GenomicRegion.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* RegionTable: the same information as a vector of GenomicRegion, but
+ * stored by column. The chrom ids are those of chrom_dict, and the
+ * names are kept together in one string, with offsets marking where
+ * each one begins. Sweeps over a table only touch the columns they use,
+ * so for example checking order never reads the names.
+ */
+class RegionTable {
+public:
+  RegionTable() : name_offsets(1, 0) {}
+  explicit RegionTable(const std::vector<GenomicRegion> &regions);
+
+  void to_regions(std::vector<GenomicRegion> &regions) const;
+
+  size_t size() const { return starts.size(); }
+  bool empty() const { return starts.empty(); }
+  void clear();
+  void reserve(const size_t n_regions, const size_t name_bytes = 0);
+
+  void push_back(const GenomicRegion &r);
+  void push_back(const chrom_id_type chrom, const size_t start,
+                 const size_t end, const std::string_view name,
+                 const float score, const char strand);
+  // add all rows of other after the rows of this table
+  void append(const RegionTable &other);
+
+  // row accessors
+  GenomicRegion get_region(const size_t i) const;
+  const std::string &get_chrom(const size_t i) const {
+    return chrom_dict::name(chrom_ids[i]);
+  }
+  chrom_id_type get_chrom_id(const size_t i) const { return chrom_ids[i]; }
+  size_t get_start(const size_t i) const { return starts[i]; }
+  size_t get_end(const size_t i) const { return ends[i]; }
+  std::string_view get_name(const size_t i) const {
+    return std::string_view(names.data() + name_offsets[i],
+                            name_offsets[i + 1] - name_offsets[i]);
+  }
+  float get_score(const size_t i) const { return scores[i]; }
+  char get_strand(const size_t i) const { return strands[i]; }
+
+  // row mutators for the fixed-width columns
+  void set_start(const size_t i, const size_t s) { starts[i] = s; }
+  void set_end(const size_t i, const size_t e) { ends[i] = e; }
+  void set_score(const size_t i, const float s) { scores[i] = s; }
+  void set_strand(const size_t i, const char s) { strands[i] = s; }
+
+  // whole columns, for sweeps that need only some of them
+  const std::vector<chrom_id_type> &get_chrom_ids() const { return chrom_ids; }
+  const std::vector<size_t> &get_starts() const { return starts; }
+  const std::vector<size_t> &get_ends() const { return ends; }
+  const std::vector<float> &get_scores() const { return scores; }
+  const std::vector<char> &get_strands() const { return strands; }
+
+  // same orders as GenomicRegion::operator< and GenomicRegion::less1
+  bool row_less(const size_t i, const RegionTable &other,
+                const size_t j) const;
+  bool row_less1(const size_t i, const RegionTable &other,
+                 const size_t j) const;
+  // same as GenomicRegion::overlaps, with row i as the object
+  bool row_overlaps(const size_t i, const RegionTable &other,
+                    const size_t j) const;
+
+  // keep only the given rows, which must be in increasing order
+  void keep_rows(const std::vector<size_t> &rows);
+
+private:
+  std::vector<chrom_id_type> chrom_ids;
+  std::vector<size_t> starts;
+  std::vector<size_t> ends;
+  std::vector<float> scores;
+  std::vector<char> strands;
+  std::string names;
+  std::vector<size_t> name_offsets; // one more than the number of rows
+};
+
+/* The algorithms below work on any table with the row accessors of
+ * RegionTable: size(), get_chrom_id(i), get_start(i), get_end(i),
+ * get_name(i), get_score(i) and get_strand(i). So they work the same
+ * way on tables stored in other forms, like RegionFile.
+ */
+
+// same orders as GenomicRegion::operator< and GenomicRegion::less1
+template <class A, class B>
+bool table_row_less(const A &a, const size_t i, const B &b, const size_t j) {
+  if (a.get_chrom_id(i) != b.get_chrom_id(j))
+    return chrom_dict::less(a.get_chrom_id(i), b.get_chrom_id(j));
+  const size_t a_start = a.get_start(i), b_start = b.get_start(j);
+  const size_t a_end = a.get_end(i), b_end = b.get_end(j);
+  return a_start < b_start ||
+         (a_start == b_start &&
+          (a_end < b_end ||
+           (a_end == b_end && a.get_strand(i) < b.get_strand(j))));
+}
+
+template <class A, class B>
+bool table_row_less1(const A &a, const size_t i, const B &b, const size_t j) {
+  if (a.get_chrom_id(i) != b.get_chrom_id(j))
+    return chrom_dict::less(a.get_chrom_id(i), b.get_chrom_id(j));
+  const size_t a_start = a.get_start(i), b_start = b.get_start(j);
+  const size_t a_end = a.get_end(i), b_end = b.get_end(j);
+  return a_end < b_end ||
+         (a_end == b_end &&
+          (a_start < b_start ||
+           (a_start == b_start && a.get_strand(i) < b.get_strand(j))));
+}
+
+// same as GenomicRegion::overlaps, with row i of a as the object
+template <class A, class B>
+bool table_row_overlaps(const A &a, const size_t i, const B &b,
+                        const size_t j) {
+  const size_t s = a.get_start(i), e = a.get_end(i);
+  const size_t o_s = b.get_start(j), o_e = b.get_end(j);
+  return a.get_chrom_id(i) == b.get_chrom_id(j) &&
+         ((s < o_e && o_e <= e) || (s <= o_s && o_s < e) ||
+          (o_s <= s && e <= o_e));
+}
+
+template <class Table> bool table_check_sorted(const Table &regions) {
+  for (size_t i = 1; i < regions.size(); ++i)
+    if (table_row_less(regions, i, regions, i - 1))
+      return false;
+  return true;
+}
+
+// the same as collapse, but for a table that can't be changed in place
+template <class Table>
+void table_collapse(const Table &regions, RegionTable &collapsed) {
+  collapsed.clear();
+  if (regions.empty())
+    return;
+  collapsed.push_back(regions.get_chrom_id(0), regions.get_start(0),
+                      regions.get_end(0), regions.get_name(0),
+                      regions.get_score(0), regions.get_strand(0));
+  for (size_t i = 1; i < regions.size(); ++i) {
+    const size_t good = collapsed.size() - 1;
+    if (table_row_overlaps(regions, i, collapsed, good)) {
+      const size_t s =
+          std::min(regions.get_start(i), collapsed.get_start(good));
+      const size_t e = std::max(regions.get_end(i), collapsed.get_end(good));
+      collapsed.set_start(good, s);
+      collapsed.set_end(good, e);
+    }
+    else
+      collapsed.push_back(regions.get_chrom_id(i), regions.get_start(i),
+                          regions.get_end(i), regions.get_name(i),
+                          regions.get_score(i), regions.get_strand(i));
+  }
+}
+
+template <class A, class B>
+void table_separate_regions(
+    const A &big_regions, const B &regions,
+    std::vector<std::pair<size_t, size_t>> &sep_regions) {
+  const size_t n_regions = regions.size();
+  const size_t n_big_regions = big_regions.size();
+  sep_regions.resize(n_big_regions);
+  size_t rr_id = 0;
+  for (size_t i = 0; i < n_big_regions; ++i) {
+    const chrom_id_type current_chrom = big_regions.get_chrom_id(i);
+    const size_t current_start = big_regions.get_start(i);
+    const size_t current_end = big_regions.get_end(i);
+    while (rr_id < n_regions &&
+           (chrom_dict::less(regions.get_chrom_id(rr_id), current_chrom) ||
+            (regions.get_chrom_id(rr_id) == current_chrom &&
+             regions.get_start(rr_id) < current_start)))
+      ++rr_id;
+    const size_t first = rr_id;
+    while (rr_id < n_regions && regions.get_chrom_id(rr_id) == current_chrom &&
+           regions.get_start(rr_id) < current_end)
+      ++rr_id;
+    sep_regions[i] = std::make_pair(first, rr_id);
+  }
+}
+
+template <class A, class B>
+void table_intersection(const A &regions_a, const B &regions_b,
+                        RegionTable &regions_c) {
+  const bool same_table = static_cast<const void *>(&regions_a) ==
+                          static_cast<const void *>(&regions_b);
+  size_t a = 0, b = 0;
+  while (a < regions_a.size() && b < regions_b.size()) {
+    if (table_row_overlaps(regions_a, a, regions_b, b))
+      regions_c.push_back(regions_b.get_chrom_id(b), regions_b.get_start(b),
+                          regions_b.get_end(b), regions_b.get_name(b),
+                          regions_b.get_score(b), regions_b.get_strand(b));
+    if (same_table && a == b) {
+      ++a;
+      ++b;
+    }
+    else if (table_row_less(regions_a, a, regions_b, b))
+      ++a;
+    else
+      ++b;
+  }
+}
+
+template <class A, class B>
+void table_intersection_by_base(const A &regions_a, const B &regions_b,
+                                RegionTable &regions_c) {
+  const bool same_table = static_cast<const void *>(&regions_a) ==
+                          static_cast<const void *>(&regions_b);
+  size_t a = 0, b = 0;
+  while (a < regions_a.size() && b < regions_b.size()) {
+    if (table_row_overlaps(regions_a, a, regions_b, b))
+      // defaults for the other columns are those of GenomicRegion
+      regions_c.push_back(
+          regions_a.get_chrom_id(a),
+          std::max(regions_a.get_start(a), regions_b.get_start(b)),
+          std::min(regions_a.get_end(a), regions_b.get_end(b)), "X", 0.0, '+');
+    if (same_table && a == b) {
+      ++a;
+      ++b;
+    }
+    else if (table_row_less1(regions_a, a, regions_b, b))
+      ++a;
+    else
+      ++b;
+  }
+}
+
+/* Versions of the functions in GenomicRegion.hpp that work on tables.
+ * Each has the same behavior as for a vector of GenomicRegion. Where
+ * the vector version would copy regions into groups, these instead give
+ * [first, last) ranges of rows.
+ */
+void collapse(RegionTable &regions);
+
+bool check_sorted(const RegionTable &regions);
+
+void separate_regions(const RegionTable &big_regions,
+                      const RegionTable &regions,
+                      std::vector<std::pair<size_t, size_t>> &sep_regions);
+
+void genomic_region_intersection(const RegionTable &regions_a,
+                                 const RegionTable &regions_b,
+                                 RegionTable &regions_c);
+
+void genomic_region_intersection_by_base(const RegionTable &regions_a,
+                                         const RegionTable &regions_b,
+                                         RegionTable &regions_c);
+
+#endif
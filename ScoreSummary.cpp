@@ -0,0 +1,350 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "ScoreSummary.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::vector;
+
+// version 1 then "SLSCRSM"; it reads differently in the other byte order
+static const uint64_t score_summary_magic = 0x4d53524353534c01ull;
+
+static_assert(sizeof(ScoreSummary::node) == 24,
+              "score summary nodes must have no padding");
+
+struct score_summary_header {
+  uint64_t magic;
+  uint64_t fanout;
+  uint64_t n_regions;
+  uint64_t n_chroms;
+  uint64_t n_levels;
+  uint64_t file_size;
+  // offsets of each part from the start of the file
+  uint64_t chrom_name_offsets;
+  uint64_t chrom_names;
+  uint64_t chrom_bounds;
+  uint64_t starts;
+  uint64_t ends;
+  uint64_t scores;
+  uint64_t level_offsets;
+  uint64_t nodes;
+};
+
+// checks that [offset, offset + n_bytes) is inside the file
+static void check_part(const score_summary_header &h, const uint64_t offset,
+                       const uint64_t n_bytes, const string &filename) {
+  if (offset > h.file_size || n_bytes > h.file_size - offset || offset % 8)
+    throw runtime_error("corrupt score summary file: " + filename);
+}
+
+// checks that the n + 1 offsets never decrease
+static void check_offsets(const uint64_t *offsets, const size_t n,
+                          const string &filename) {
+  for (size_t i = 0; i < n; ++i)
+    if (offsets[i + 1] < offsets[i])
+      throw runtime_error("corrupt score summary file: " + filename);
+}
+
+/* checks that the levels are those write_score_summary makes: each has
+ * one node for every fanout nodes of the level below, the bottom level
+ * being the regions, up to a level with one node
+ */
+static void check_levels(const uint64_t *level_offsets, const size_t n_levels,
+                         const size_t n_regions, const string &filename) {
+  if (level_offsets[0] != 0)
+    throw runtime_error("corrupt score summary file: " + filename);
+  size_t below_size = n_regions, level = 0;
+  for (; below_size > 1; ++level) {
+    const size_t size = (below_size + ScoreSummary::fanout - 1) /
+                        ScoreSummary::fanout;
+    if (level == n_levels || level_offsets[level + 1] < level_offsets[level] ||
+        level_offsets[level + 1] - level_offsets[level] != size)
+      throw runtime_error("corrupt score summary file: " + filename);
+    below_size = size;
+  }
+  if (level != n_levels)
+    throw runtime_error("corrupt score summary file: " + filename);
+}
+
+ScoreSummary::ScoreSummary(const string &filename) : file(filename) {
+  score_summary_header h;
+  if (file.size() < sizeof(h))
+    throw runtime_error("not a score summary file: " + filename);
+  std::memcpy(&h, file.data(), sizeof(h));
+  if (h.magic != score_summary_magic)
+    throw runtime_error("not a score summary file, or from a different "
+                        "machine type: " +
+                        filename);
+  if (h.file_size != file.size())
+    throw runtime_error("incomplete score summary file: " + filename);
+  if (h.fanout != fanout || h.n_regions > h.file_size ||
+      h.n_chroms > h.file_size || h.n_levels > 64)
+    throw runtime_error("corrupt score summary file: " + filename);
+
+  n_regions = h.n_regions;
+  n_chroms = h.n_chroms;
+  n_levels = h.n_levels;
+  const char *data = file.data();
+
+  check_part(h, h.chrom_name_offsets, (h.n_chroms + 1) * sizeof(uint64_t),
+             filename);
+  const uint64_t *chrom_name_offsets =
+      reinterpret_cast<const uint64_t *>(data + h.chrom_name_offsets);
+  check_offsets(chrom_name_offsets, h.n_chroms, filename);
+  check_part(h, h.chrom_names, chrom_name_offsets[h.n_chroms], filename);
+  const char *chrom_names = data + h.chrom_names;
+  for (size_t i = 0; i < h.n_chroms; ++i) {
+    const chrom_id_type c = chrom_dict::assign(
+        string_view(chrom_names + chrom_name_offsets[i],
+                    chrom_name_offsets[i + 1] - chrom_name_offsets[i]));
+    if (chrom_index.size() <= c)
+      chrom_index.resize(c + 1, h.n_chroms);
+    chrom_index[c] = i;
+  }
+
+  check_part(h, h.chrom_bounds, (h.n_chroms + 1) * sizeof(uint64_t),
+             filename);
+  check_part(h, h.starts, n_regions * sizeof(uint64_t), filename);
+  check_part(h, h.ends, n_regions * sizeof(uint64_t), filename);
+  check_part(h, h.scores, n_regions * sizeof(float), filename);
+  check_part(h, h.level_offsets, (n_levels + 1) * sizeof(uint64_t),
+             filename);
+  chrom_bounds = reinterpret_cast<const uint64_t *>(data + h.chrom_bounds);
+  starts = reinterpret_cast<const uint64_t *>(data + h.starts);
+  ends = reinterpret_cast<const uint64_t *>(data + h.ends);
+  scores = reinterpret_cast<const float *>(data + h.scores);
+  level_offsets = reinterpret_cast<const uint64_t *>(data + h.level_offsets);
+  check_offsets(chrom_bounds, n_chroms, filename);
+  if (chrom_bounds[0] != 0 || chrom_bounds[n_chroms] != n_regions)
+    throw runtime_error("corrupt score summary file: " + filename);
+  check_levels(level_offsets, n_levels, n_regions, filename);
+  check_part(h, h.nodes, level_offsets[n_levels] * sizeof(node), filename);
+  nodes = reinterpret_cast<const node *>(data + h.nodes);
+
+  // summarize searches each chrom and takes widths without checks
+  for (size_t c = 0; c < n_chroms; ++c)
+    for (size_t i = chrom_bounds[c]; i < chrom_bounds[c + 1]; ++i)
+      if (ends[i] < starts[i] ||
+          (i > chrom_bounds[c] && starts[i] < ends[i - 1]))
+        throw runtime_error("corrupt score summary file: " + filename);
+}
+
+void ScoreSummary::add_region(const size_t i, score_summary &s) const {
+  const size_t width = ends[i] - starts[i];
+  s.covered += width;
+  s.sum += static_cast<double>(scores[i]) * width;
+  s.min = std::min(s.min, static_cast<double>(scores[i]));
+  s.max = std::max(s.max, static_cast<double>(scores[i]));
+}
+
+void ScoreSummary::add_node(const size_t level, const size_t i,
+                            score_summary &s) const {
+  if (level == 0) {
+    add_region(i, s);
+    return;
+  }
+  const node &n = nodes[level_offsets[level - 1] + i];
+  s.covered += n.covered;
+  s.sum += n.sum;
+  s.min = std::min(s.min, static_cast<double>(n.min));
+  s.max = std::max(s.max, static_cast<double>(n.max));
+}
+
+score_summary ScoreSummary::summarize(const chrom_id_type chrom,
+                                      const size_t start,
+                                      const size_t end) const {
+  score_summary s;
+  if (chrom >= chrom_index.size() || start >= end)
+    return s;
+  const size_t c = chrom_index[chrom];
+  if (c == n_chroms)
+    return s;
+  const uint64_t *chrom_ends = ends + chrom_bounds[c];
+  const uint64_t *chrom_starts = starts + chrom_bounds[c];
+  const size_t n = chrom_bounds[c + 1] - chrom_bounds[c];
+  // regions [first, last) of the chrom overlap the range
+  size_t first = std::upper_bound(chrom_ends, chrom_ends + n, start) -
+                 chrom_ends + chrom_bounds[c];
+  size_t last = std::lower_bound(chrom_starts, chrom_starts + n, end) -
+                chrom_starts + chrom_bounds[c];
+  if (first >= last)
+    return s;
+
+  // the regions at the ends may be only partly in the range
+  const auto add_clipped = [&](const size_t i) {
+    const size_t width = std::min<size_t>(end, ends[i]) -
+                         std::max<size_t>(start, starts[i]);
+    s.covered += width;
+    s.sum += static_cast<double>(scores[i]) * width;
+    s.min = std::min(s.min, static_cast<double>(scores[i]));
+    s.max = std::max(s.max, static_cast<double>(scores[i]));
+  };
+  add_clipped(first++);
+  if (first < last)
+    add_clipped(--last);
+
+  // those between are covered by whole nodes, from the bottom level up
+  for (size_t level = 0; first < last; ++level) {
+    while (first < last && first % fanout != 0)
+      add_node(level, first++, s);
+    while (first < last && last % fanout != 0)
+      add_node(level, --last, s);
+    first /= fanout;
+    last /= fanout;
+  }
+  return s;
+}
+
+// appends a part to the file and gives its offset
+template <class T>
+static uint64_t write_part(std::ofstream &out, uint64_t &offset,
+                           const vector<T> &part) {
+  static const char zeros[8] = {};
+  const size_t padding = (8 - offset % 8) % 8;
+  out.write(zeros, padding);
+  offset += padding;
+  const uint64_t part_offset = offset;
+  out.write(reinterpret_cast<const char *>(part.data()),
+            part.size() * sizeof(T));
+  offset += part.size() * sizeof(T);
+  return part_offset;
+}
+
+void write_score_summary(const string &filename,
+                         const vector<chrom_id_type> &chroms,
+                         const vector<size_t> &starts,
+                         const vector<size_t> &ends,
+                         const vector<float> &scores) {
+  const size_t n = chroms.size();
+  if (starts.size() != n || ends.size() != n || scores.size() != n)
+    throw runtime_error("different numbers of chroms, starts, ends and scores");
+
+  // the non-empty regions, with the chroms in the order they appear
+  vector<uint64_t> kept_starts, kept_ends;
+  vector<float> kept_scores;
+  vector<char> chrom_names;
+  vector<uint64_t> chrom_name_offsets(1, 0), chrom_bounds(1, 0);
+  vector<bool> seen;
+  chrom_id_type chrom = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (ends[i] < starts[i])
+      throw runtime_error("region ends before it starts in row " +
+                          to_string(i));
+    if (starts[i] == ends[i])
+      continue;
+    if (kept_starts.empty() || chroms[i] != chrom) {
+      chrom = chroms[i];
+      if (seen.size() <= chrom)
+        seen.resize(chrom + 1);
+      if (seen[chrom])
+        throw runtime_error("regions not grouped by chrom in row " +
+                            to_string(i));
+      seen[chrom] = true;
+      if (!kept_starts.empty())
+        chrom_bounds.push_back(kept_starts.size());
+      const string &name = chrom_dict::name(chrom);
+      chrom_names.insert(std::end(chrom_names), std::begin(name),
+                         std::end(name));
+      chrom_name_offsets.push_back(chrom_names.size());
+    }
+    else if (starts[i] < kept_ends.back())
+      throw runtime_error("regions not sorted or overlapping near " +
+                          chrom_dict::name(chrom) + ":" +
+                          to_string(starts[i]));
+    kept_starts.push_back(starts[i]);
+    kept_ends.push_back(ends[i]);
+    kept_scores.push_back(scores[i]);
+  }
+  const size_t n_kept = kept_starts.size();
+  if (n_kept > 0)
+    chrom_bounds.push_back(n_kept);
+
+  // each level has one node for every fanout items of the level below,
+  // up to a level with one node
+  const size_t fanout = ScoreSummary::fanout;
+  vector<ScoreSummary::node> nodes;
+  vector<uint64_t> level_offsets(1, 0);
+  size_t below_first = 0, below_size = n_kept;
+  for (size_t level = 1; below_size > 1; ++level) {
+    const size_t first = nodes.size();
+    for (size_t i = 0; i < below_size; i += fanout) {
+      ScoreSummary::node x{0.0, 0, std::numeric_limits<float>::infinity(),
+                           -std::numeric_limits<float>::infinity()};
+      for (size_t j = i; j < std::min(below_size, i + fanout); ++j)
+        if (level == 1) {
+          const size_t width = kept_ends[j] - kept_starts[j];
+          x.sum += static_cast<double>(kept_scores[j]) * width;
+          x.covered += width;
+          x.min = std::min(x.min, kept_scores[j]);
+          x.max = std::max(x.max, kept_scores[j]);
+        }
+        else {
+          const ScoreSummary::node y = nodes[below_first + j];
+          x.sum += y.sum;
+          x.covered += y.covered;
+          x.min = std::min(x.min, y.min);
+          x.max = std::max(x.max, y.max);
+        }
+      nodes.push_back(x);
+    }
+    level_offsets.push_back(nodes.size());
+    below_first = first;
+    below_size = nodes.size() - first;
+  }
+
+  std::ofstream out(filename, std::ios::binary);
+  if (!out)
+    throw runtime_error("failed to open file " + filename);
+  score_summary_header h{};
+  h.magic = score_summary_magic;
+  h.fanout = fanout;
+  h.n_regions = n_kept;
+  h.n_chroms = chrom_name_offsets.size() - 1;
+  h.n_levels = level_offsets.size() - 1;
+  // the header is written again once the offsets are known
+  out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+  uint64_t offset = sizeof(h);
+  h.chrom_name_offsets = write_part(out, offset, chrom_name_offsets);
+  h.chrom_names = write_part(out, offset, chrom_names);
+  h.chrom_bounds = write_part(out, offset, chrom_bounds);
+  h.starts = write_part(out, offset, kept_starts);
+  h.ends = write_part(out, offset, kept_ends);
+  h.scores = write_part(out, offset, kept_scores);
+  h.level_offsets = write_part(out, offset, level_offsets);
+  h.nodes = write_part(out, offset, nodes);
+  h.file_size = offset;
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+  out.close();
+  if (!out)
+    throw runtime_error("error writing file " + filename);
+}
+
+void write_score_summary(const string &filename, const RegionTable &regions) {
+  write_score_summary(filename, regions.get_chrom_ids(), regions.get_starts(),
+                      regions.get_ends(), regions.get_scores());
+}
@@ -0,0 +1,122 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef SCORE_SUMMARY_HPP
+#define SCORE_SUMMARY_HPP
+
+#include "RegionTable.hpp"
+#include "chrom_dict.hpp"
+#include "smithlab_os.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+// the scores of the bases covered in a range
+struct score_summary {
+  size_t covered{}; // the number of bases with a score
+  double sum{};     // of the score of each covered base
+  double min{std::numeric_limits<double>::infinity()};
+  double max{-std::numeric_limits<double>::infinity()};
+  double mean() const { return covered == 0 ? 0.0 : sum / covered; }
+};
+
+/* ScoreSummary: the scores of a set of regions, as in a bedGraph, with
+ * summaries at several zoom levels so that any range can be summarized
+ * in O(log n) time. Each node of level 1 summarizes `fanout` regions,
+ * and each node of a higher level `fanout` nodes of the level below. A
+ * query finds the regions that overlap the range by binary search,
+ * clips the two at its ends, and covers those between with at most
+ * 2*(fanout-1) nodes of each level.
+ *
+ * Summaries are written to a file with write_score_summary and read
+ * back by mapping the file into memory, as for RegionFile, so opening
+ * one costs almost nothing and many processes can share it. Numbers are
+ * in the byte order of the machine that wrote the file.
+ */
+class ScoreSummary {
+public:
+  explicit ScoreSummary(const std::string &filename);
+
+  size_t size() const { return n_regions; }
+
+  // the summary of the bases in [start, end) on chrom
+  score_summary summarize(const chrom_id_type chrom, const size_t start,
+                          const size_t end) const;
+  template <class T> score_summary summarize(const T &region) const {
+    return summarize(region.get_chrom_id(), region.get_start(),
+                     region.get_end());
+  }
+
+  static const size_t fanout = 4;
+
+  struct node {
+    double sum;
+    uint64_t covered;
+    float min;
+    float max;
+  };
+
+private:
+  void add_region(const size_t i, score_summary &s) const;
+  void add_node(const size_t level, const size_t i, score_summary &s) const;
+
+  MappedFile file;
+  size_t n_regions;
+  size_t n_chroms;
+  size_t n_levels;
+  // index in the file of each chrom id, or n_chroms
+  std::vector<uint32_t> chrom_index;
+  const uint64_t *chrom_bounds; // first region of each chrom, and the end
+  const uint64_t *starts;
+  const uint64_t *ends;
+  const float *scores;
+  const uint64_t *level_offsets; // first node of each level above 0
+  const node *nodes;
+};
+
+/* Write the summaries of a set of regions to a file that ScoreSummary
+ * can open. The regions of each chrom must be together, sorted by
+ * start and not overlapping, as in a bedGraph; the order of the chroms
+ * doesn't matter. Empty regions are left out.
+ */
+void write_score_summary(const std::string &filename,
+                         const std::vector<chrom_id_type> &chroms,
+                         const std::vector<size_t> &starts,
+                         const std::vector<size_t> &ends,
+                         const std::vector<float> &scores);
+
+void write_score_summary(const std::string &filename,
+                         const RegionTable &regions);
+
+// regions of any type, like GenomicRegion
+template <class T>
+void write_score_summary(const std::string &filename,
+                         const std::vector<T> &regions) {
+  std::vector<chrom_id_type> chroms(regions.size());
+  std::vector<size_t> starts(regions.size()), ends(regions.size());
+  std::vector<float> scores(regions.size());
+  for (size_t i = 0; i < regions.size(); ++i) {
+    chroms[i] = regions[i].get_chrom_id();
+    starts[i] = regions[i].get_start();
+    ends[i] = regions[i].get_end();
+    scores[i] = regions[i].get_score();
+  }
+  write_score_summary(filename, chroms, starts, ends, scores);
+}
+
+#endif
@@ -0,0 +1,585 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "bed_io.hpp"
+#include "chrom_dict.hpp"
+#include "parallel_tasks.hpp"
+#include "smithlab_os.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::exception_ptr;
+using std::runtime_error;
+using std::string;
+using std::string_view;
+using std::vector;
+
+// same as isspace in the "C" locale
+static inline bool is_bed_space(const char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline void skip_bed_space(const string_view line, size_t &i) {
+  while (i < line.size() && is_bed_space(line[i]))
+    ++i;
+}
+
+static inline string_view next_bed_field(const string_view line, size_t &i) {
+  skip_bed_space(line, i);
+  const size_t j = i;
+  while (i < line.size() && !is_bed_space(line[i]))
+    ++i;
+  return line.substr(j, i - j);
+}
+
+// same value as the atoi used by GenomicRegion(line)
+static inline size_t parse_bed_pos(const string_view f) {
+  const char *first = f.data(), *last = f.data() + f.size();
+  const bool negative = first != last && *first == '-';
+  if (first != last && (*first == '-' || *first == '+'))
+    ++first;
+  size_t pos = 0;
+  std::from_chars(first, last, pos);
+  return negative ? 0 - pos : pos;
+}
+
+/* Scores like "12.5" are computed directly: when the digits fit in 15
+ * decimal places, both the digits and the power of ten are exact as
+ * doubles, and one division rounds the same way strtod does. Anything
+ * else is given to strtod, as atof did before, so the values are the
+ * same to the last bit. The field has no terminating null in the line,
+ * so it is copied first.
+ */
+static inline float parse_bed_score(const string_view f) {
+  static const double powers_of_ten[] = {1e0, 1e1, 1e2,  1e3,  1e4,  1e5,
+                                         1e6, 1e7, 1e8,  1e9,  1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15};
+  static const size_t max_exact_digits = 15;
+  size_t i = 0;
+  const bool negative = !f.empty() && f[0] == '-';
+  if (negative)
+    ++i;
+  uint64_t digits = 0;
+  size_t n_digits = 0, n_frac_digits = 0;
+  bool seen_point = false;
+  for (; i < f.size(); ++i) {
+    const char c = f[i];
+    if (c >= '0' && c <= '9') {
+      digits = 10 * digits + (c - '0');
+      ++n_digits;
+      n_frac_digits += seen_point;
+    }
+    else if (c == '.' && !seen_point)
+      seen_point = true;
+    else
+      break;
+  }
+  if (i == f.size() && n_digits > 0 && n_digits <= max_exact_digits) {
+    const double v = digits / powers_of_ten[n_frac_digits];
+    return negative ? -v : v;
+  }
+
+  static const size_t max_score_chars = 63;
+  if (f.size() > max_score_chars)
+    return std::strtod(string(f).c_str(), nullptr);
+  char buf[max_score_chars + 1];
+  std::copy_n(f.data(), f.size(), buf);
+  buf[f.size()] = '\0';
+  return std::strtod(buf, nullptr);
+}
+
+bool is_bed_header(const string_view line) {
+  return line.substr(0, 7) == "browser" || line.substr(0, 5) == "track";
+}
+
+void parse_bed_line(const string_view line, bed_fields &f) {
+  size_t i = 0;
+  skip_bed_space(line, i);
+  if (i == line.size())
+    throw runtime_error(
+        "malformatted BED file contains only one"
+        "column in the line below "
+        "(a properly formatted BED file must contain at least three):\n" +
+        string(line));
+  f.chrom = next_bed_field(line, i);
+  if (i == line.size())
+    throw runtime_error(
+        "malformatted BED file contains only two "
+        "columns in the line below "
+        "(a properly formatted BED file must contain at least three):\n" +
+        string(line));
+  f.start = parse_bed_pos(next_bed_field(line, i));
+  f.end = parse_bed_pos(next_bed_field(line, i));
+  f.name = next_bed_field(line, i);
+  f.score = parse_bed_score(next_bed_field(line, i));
+  const string_view strand = next_bed_field(line, i);
+  f.strand = !strand.empty() && strand[0] == '-' ? '-' : '+';
+}
+
+/* Cut the mapped file into pieces that each begin at the start of a
+ * line, parse the pieces in parallel, and call add(part, fields) for
+ * each line of piece k, in order. Errors are kept for each piece, and
+ * the one from the earliest piece is thrown.
+ */
+template <class Part, class Add>
+static void parse_bed_parts(const string &filename, const size_t n_threads,
+                            vector<Part> &parts, Add add) {
+  const MappedFile file(filename);
+  const char *const data = file.data();
+  const size_t size = file.size();
+
+  // more pieces than threads, so a slow piece doesn't hold up the rest
+  static const size_t min_part_size = 1 << 20;
+  static const size_t parts_per_thread = 4;
+  const size_t n_parts = std::max<size_t>(
+      1, std::min(size / min_part_size, n_threads * parts_per_thread));
+  vector<size_t> cuts(n_parts + 1, size);
+  cuts[0] = 0;
+  for (size_t k = 1; k < n_parts; ++k) {
+    // a piece starts after the first newline at or after its nominal start
+    const size_t from = std::max(cuts[k - 1], (size * k) / n_parts - 1);
+    const void *nl = std::memchr(data + from, '\n', size - from);
+    cuts[k] = nl ? static_cast<const char *>(nl) - data + 1 : size;
+  }
+
+  parts.clear();
+  parts.resize(n_parts);
+  vector<exception_ptr> errors(n_parts);
+  run_tasks(n_parts, n_threads, [&](const size_t k) {
+    try {
+      bed_fields f;
+      const char *p = data + cuts[k];
+      const char *const part_end = data + cuts[k + 1];
+      while (p < part_end) {
+        const void *nl = std::memchr(p, '\n', part_end - p);
+        const char *line_end = nl ? static_cast<const char *>(nl) : part_end;
+        const string_view line(p, line_end - p);
+        if (!is_bed_header(line)) {
+          parse_bed_line(line, f);
+          add(parts[k], f);
+        }
+        p = line_end + 1;
+      }
+    }
+    catch (...) {
+      errors[k] = std::current_exception();
+    }
+  });
+  for (const auto &e : errors)
+    if (e)
+      std::rethrow_exception(e);
+}
+
+/* Lines are usually sorted by chrom, so most lines have the same chrom
+ * as the line before, and the lookup in chrom_dict can be skipped.
+ */
+struct bed_chrom_cache {
+  string_view chrom;
+  chrom_id_type id{};
+  chrom_id_type get(const string_view c) {
+    if (c != chrom || chrom.empty()) {
+      id = chrom_dict::assign(c);
+      chrom = c;
+    }
+    return id;
+  }
+};
+
+/* Files that can't be mapped are read as a stream: compressed files,
+ * and those that aren't regular files, like pipes and /dev/stdin.
+ */
+static bool read_bed_as_stream(const string &filename) {
+  struct stat st;
+  return has_gz_ext(filename) || stat(filename.c_str(), &st) != 0 ||
+         !S_ISREG(st.st_mode);
+}
+
+void read_bed_file(const string &filename, vector<GenomicRegion> &regions,
+                   const size_t n_threads) {
+  struct region_part {
+    vector<GenomicRegion> regions;
+    bed_chrom_cache cache;
+  };
+  if (read_bed_as_stream(filename)) {
+    BedReader reader(filename);
+    GenomicRegion r;
+    while (reader.read(r))
+      regions.push_back(r);
+    return;
+  }
+  vector<region_part> parts;
+  parse_bed_parts(filename, n_threads, parts,
+                  [](region_part &p, const bed_fields &f) {
+                    p.regions.emplace_back(p.cache.get(f.chrom), f.start,
+                                           f.end, f.name, f.score, f.strand);
+                  });
+  size_t total = regions.size();
+  for (const auto &p : parts)
+    total += p.regions.size();
+  regions.reserve(total);
+  for (auto &p : parts)
+    std::move(std::begin(p.regions), std::end(p.regions),
+              std::back_inserter(regions));
+}
+
+void read_bed_file(const string &filename, RegionTable &regions,
+                   const size_t n_threads) {
+  struct table_part {
+    RegionTable regions;
+    bed_chrom_cache cache;
+  };
+  if (read_bed_as_stream(filename)) {
+    BedReader reader(filename);
+    bed_fields f;
+    while (reader.read(f))
+      regions.push_back(chrom_dict::assign(f.chrom), f.start, f.end, f.name,
+                        f.score, f.strand);
+    return;
+  }
+  vector<table_part> parts;
+  parse_bed_parts(filename, n_threads, parts,
+                  [](table_part &p, const bed_fields &f) {
+                    p.regions.push_back(p.cache.get(f.chrom), f.start, f.end,
+                                        f.name, f.score, f.strand);
+                  });
+  for (const auto &p : parts)
+    regions.append(p.regions);
+}
+
+void read_bed_file(const string &filename, vector<CompactRegion> &regions,
+                   const size_t n_threads) {
+  if (read_bed_as_stream(filename)) {
+    BedReader reader(filename);
+    bed_fields f;
+    while (reader.read(f))
+      regions.emplace_back(chrom_dict::assign(f.chrom), f.start, f.end, f.name,
+                           f.score, f.strand);
+    return;
+  }
+  struct compact_part {
+    vector<CompactRegion> regions;
+    bed_chrom_cache cache;
+  };
+  vector<compact_part> parts;
+  parse_bed_parts(filename, n_threads, parts,
+                  [](compact_part &p, const bed_fields &f) {
+                    p.regions.emplace_back(p.cache.get(f.chrom), f.start,
+                                           f.end, f.name, f.score, f.strand);
+                  });
+  size_t total = regions.size();
+  for (const auto &p : parts)
+    total += p.regions.size();
+  regions.reserve(total);
+  for (const auto &p : parts)
+    regions.insert(std::end(regions), std::begin(p.regions),
+                   std::end(p.regions));
+}
+
+BedReader::BedReader(const string &filename, const size_t buffer_size)
+    : filename(filename), in(gzopen(filename.c_str(), "rb")),
+      buffer(std::max<size_t>(buffer_size, 1)), pos(0), filled(0),
+      at_eof(false), line_number(0), last_chrom_id(0) {
+  if (in == nullptr)
+    throw runtime_error("failed to open file " + filename);
+  // zlib's own buffer is 8 KB by default
+  static const unsigned zlib_buffer_size = 1 << 17;
+  gzbuffer(in, zlib_buffer_size);
+}
+
+BedReader::~BedReader() { gzclose(in); }
+
+bool BedReader::next_line(string_view &line) {
+  for (;;) {
+    const void *nl = std::memchr(buffer.data() + pos, '\n', filled - pos);
+    if (nl != nullptr) {
+      const size_t line_end = static_cast<const char *>(nl) - buffer.data();
+      line = string_view(buffer.data() + pos, line_end - pos);
+      pos = line_end + 1;
+      ++line_number;
+      return true;
+    }
+    if (at_eof) {
+      if (pos == filled)
+        return false;
+      // the last line has no newline
+      line = string_view(buffer.data() + pos, filled - pos);
+      pos = filled;
+      ++line_number;
+      return true;
+    }
+    // keep the partial line, moving it to the front, and read more
+    std::copy(std::begin(buffer) + pos, std::begin(buffer) + filled,
+              std::begin(buffer));
+    filled -= pos;
+    pos = 0;
+    if (filled == buffer.size())
+      buffer.resize(2 * buffer.size());
+    const int n_read = gzread(in, buffer.data() + filled,
+                              static_cast<unsigned>(std::min<size_t>(
+                                  buffer.size() - filled, 1u << 30)));
+    if (n_read < 0)
+      throw runtime_error("error reading file " + filename);
+    at_eof = n_read == 0;
+    filled += n_read;
+  }
+}
+
+chrom_id_type BedReader::get_chrom_id(const string_view chrom) {
+  // the buffer is reused, so the last chrom is kept as a copy
+  if (chrom != last_chrom || last_chrom.empty()) {
+    last_chrom_id = chrom_dict::assign(chrom);
+    last_chrom = chrom;
+  }
+  return last_chrom_id;
+}
+
+bool BedReader::read(bed_fields &f) {
+  string_view line;
+  return read(f, line);
+}
+
+bool BedReader::read(bed_fields &f, string_view &line) {
+  while (next_line(line))
+    if (!is_bed_header(line)) {
+      parse_bed_line(line, f);
+      return true;
+    }
+  return false;
+}
+
+bool BedReader::read(GenomicRegion &r) {
+  string_view line;
+  return read(r, line);
+}
+
+bool BedReader::read(GenomicRegion &r, string_view &line) {
+  bed_fields f;
+  if (!read(f, line))
+    return false;
+  r.set_chrom_id(get_chrom_id(f.chrom));
+  r.set_start(f.start);
+  r.set_end(f.end);
+  r.set_name(f.name);
+  r.set_score(f.score);
+  r.set_strand(f.strand);
+  return true;
+}
+
+size_t BedReader::read(vector<GenomicRegion> &batch, const size_t max_regions) {
+  // regions already in the batch are overwritten, so a batch that is
+  // passed in again reuses the memory for its names
+  size_t n_read = 0;
+  GenomicRegion r;
+  for (; n_read < max_regions; ++n_read)
+    if (n_read < batch.size()) {
+      if (!read(batch[n_read]))
+        break;
+    }
+    else {
+      if (!read(r))
+        break;
+      batch.push_back(r);
+    }
+  batch.erase(std::begin(batch) + n_read, std::end(batch));
+  return n_read;
+}
+
+size_t BedReader::read(RegionTable &batch, const size_t max_regions) {
+  batch.clear();
+  bed_fields f;
+  while (batch.size() < max_regions && read(f))
+    batch.push_back(get_chrom_id(f.chrom), f.start, f.end, f.name, f.score,
+                    f.strand);
+  return batch.size();
+}
+
+BedWriter::BedWriter(const string &filename, const bool compress,
+                     const size_t buffer_size)
+    : filename(filename), buffer(std::max<size_t>(buffer_size, 1)),
+      filled(0) {
+  if (compress) {
+    gz_out.reset(new ogzfstream(filename));
+    if (!*gz_out)
+      throw runtime_error("failed to open file " + filename);
+  }
+  else {
+    out.open(filename, std::ios::binary);
+    if (!out)
+      throw runtime_error("failed to open file " + filename);
+  }
+}
+
+BedWriter::~BedWriter() {
+  try {
+    close();
+  }
+  catch (...) {
+  }
+}
+
+void BedWriter::write_out(const char *data, const size_t n_bytes) {
+  if (gz_out) {
+    if (gzwrite(gz_out->fileobj, data, static_cast<unsigned>(n_bytes)) !=
+        static_cast<int>(n_bytes))
+      throw runtime_error("error writing file " + filename);
+  }
+  else if (!out.write(data, n_bytes))
+    throw runtime_error("error writing file " + filename);
+}
+
+void BedWriter::flush() {
+  if (filled > 0)
+    write_out(buffer.data(), filled);
+  filled = 0;
+}
+
+void BedWriter::close() {
+  if (!gz_out && !out.is_open())
+    return;
+  flush();
+  if (gz_out) {
+    const int status = gzclose_w(gz_out->fileobj);
+    // stop the ogzfstream from closing the file again
+    gz_out->fileobj = nullptr;
+    gz_out.reset();
+    if (status != Z_OK)
+      throw runtime_error("error writing file " + filename);
+  }
+  else {
+    out.close();
+    if (!out)
+      throw runtime_error("error writing file " + filename);
+  }
+}
+
+char *BedWriter::reserve(const size_t n_bytes) {
+  if (buffer.size() - filled < n_bytes) {
+    flush();
+    if (buffer.size() < n_bytes)
+      buffer.resize(n_bytes);
+  }
+  return buffer.data() + filled;
+}
+
+/* The same text as operator<< on an ostream with default flags, which
+ * is printf with "%g". Whole numbers below one million, which are most
+ * scores, print as integers in that format, and are done here directly.
+ */
+static inline char *format_bed_score(char *p, const float score) {
+  static const size_t max_score_chars = 16;
+  const double v = score;
+  if (std::abs(v) < 1e6 && v == std::trunc(v) && !std::signbit(v))
+    return std::to_chars(p, p + max_score_chars, static_cast<int>(v)).ptr;
+  return p + std::snprintf(p, max_score_chars, "%g", v);
+}
+
+void BedWriter::write_fields(const string &chrom, const size_t start,
+                             const size_t end, const string_view name,
+                             const float score, const char strand) {
+  // two positions, the score and the tabs take at most this many bytes
+  static const size_t max_number_chars = 64;
+  char *const first = reserve(chrom.size() + name.size() + max_number_chars);
+  char *p = std::copy_n(chrom.data(), chrom.size(), first);
+  *p++ = '\t';
+  p = std::to_chars(p, p + max_number_chars, start).ptr;
+  *p++ = '\t';
+  p = std::to_chars(p, p + max_number_chars, end).ptr;
+  if (!name.empty()) {
+    *p++ = '\t';
+    p = std::copy_n(name.data(), name.size(), p);
+    *p++ = '\t';
+    p = format_bed_score(p, score);
+    *p++ = '\t';
+    *p++ = strand;
+  }
+  *p++ = '\n';
+  filled += p - first;
+}
+
+void BedWriter::write(const GenomicRegion &r) {
+  write_fields(r.get_chrom(), r.get_start(), r.get_end(), r.get_name(),
+               r.get_score(), r.get_strand());
+}
+
+void BedWriter::write(const SimpleGenomicRegion &r) {
+  write_fields(r.get_chrom(), r.get_start(), r.get_end(), string_view(), 0,
+               '+');
+}
+
+void BedWriter::write(const CompactRegion &r) {
+  write_fields(r.get_chrom(), r.get_start(), r.get_end(), r.get_name(),
+               r.get_score(), r.get_strand());
+}
+
+void BedWriter::write(const RegionTable &regions, const size_t i) {
+  write_fields(regions.get_chrom(i), regions.get_start(i), regions.get_end(i),
+               regions.get_name(i), regions.get_score(i),
+               regions.get_strand(i));
+}
+
+void BedWriter::write(const RegionTable &regions) {
+  for (size_t i = 0; i < regions.size(); ++i)
+    write(regions, i);
+}
+
+/* Whole values, like depths, are written in full, since "%g" would
+ * round those of a million or more. Others are as with "%g".
+ */
+static inline char *format_bedgraph_value(char *p, const double v) {
+  static const size_t max_value_chars = 32;
+  if (std::abs(v) < 1e15 && v == std::trunc(v) && !std::signbit(v))
+    return std::to_chars(p, p + max_value_chars, static_cast<int64_t>(v)).ptr;
+  return p + std::snprintf(p, max_value_chars, "%g", v);
+}
+
+void BedWriter::write(const bedgraph_record &r) {
+  static const size_t max_number_chars = 80;
+  const string &chrom = chrom_dict::name(r.chrom);
+  char *const first = reserve(chrom.size() + max_number_chars);
+  char *p = std::copy_n(chrom.data(), chrom.size(), first);
+  *p++ = '\t';
+  p = std::to_chars(p, p + max_number_chars, r.start).ptr;
+  *p++ = '\t';
+  p = std::to_chars(p, p + max_number_chars, r.end).ptr;
+  *p++ = '\t';
+  p = format_bedgraph_value(p, r.value);
+  *p++ = '\n';
+  filled += p - first;
+}
+
+void BedWriter::write(const string_view text) {
+  if (text.size() > buffer.size()) {
+    flush();
+    write_out(text.data(), text.size());
+    return;
+  }
+  char *const first = reserve(text.size());
+  std::copy_n(text.data(), text.size(), first);
+  filled += text.size();
+}
@@ -0,0 +1,174 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef BED_IO_HPP
+#define BED_IO_HPP
+
+#include "CompactRegion.hpp"
+#include "GenomicRegion.hpp"
+#include "RegionTable.hpp"
+#include "zlib_wrapper.hpp"
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* The fields of one line in BED format, as views into the line. Fields
+ * missing from the line are given the values that GenomicRegion(line)
+ * would give them.
+ */
+struct bed_fields {
+  std::string_view chrom;
+  size_t start{};
+  size_t end{};
+  std::string_view name;
+  float score{};
+  char strand{'+'};
+};
+
+/* One line of a bedGraph file: a value, like a depth or a mean, for all
+ * bases in [start, end) on the chrom.
+ */
+struct bedgraph_record {
+  chrom_id_type chrom{};
+  size_t start{};
+  size_t end{};
+  double value{};
+};
+
+// true for the "browser" and "track" lines that ReadBEDFile skips
+bool is_bed_header(const std::string_view line);
+
+/* Parse one line, without its newline, exactly as GenomicRegion(line)
+ * does, including the same errors for lines with fewer than three
+ * columns. No memory is allocated.
+ */
+void parse_bed_line(const std::string_view line, bed_fields &f);
+
+/* Read a BED file, adding its regions to the end of the vector or
+ * table, in the order of the file. The file is mapped into memory and
+ * cut at line boundaries into pieces that are parsed at the same time
+ * by up to n_threads threads. Header lines are skipped, and any other
+ * line is parsed as by parse_bed_line. If a line can't be parsed, the
+ * error is for the first such line in the file. Files with names ending
+ * in ".gz", and files that can't be mapped, like pipes, are read with a
+ * BedReader instead.
+ */
+void read_bed_file(const std::string &filename,
+                   std::vector<GenomicRegion> &regions,
+                   const size_t n_threads = 1);
+
+void read_bed_file(const std::string &filename, RegionTable &regions,
+                   const size_t n_threads = 1);
+
+void read_bed_file(const std::string &filename,
+                   std::vector<CompactRegion> &regions,
+                   const size_t n_threads = 1);
+
+/* BedReader: reads regions from a BED file one at a time, or in
+ * batches, using a buffer of fixed size. The file can be plain text or
+ * compressed with gzip, which is detected from the contents, not the
+ * name. Header lines are skipped and lines are parsed as by
+ * parse_bed_line. The buffer only grows if one line is longer than it.
+ */
+class BedReader {
+public:
+  explicit BedReader(const std::string &filename,
+                     const size_t buffer_size = default_buffer_size);
+  ~BedReader();
+  BedReader(const BedReader &) = delete;
+  BedReader &operator=(const BedReader &) = delete;
+
+  // false once there are no more regions in the file
+  bool read(GenomicRegion &r);
+  // the views in f are valid until the next call to read
+  bool read(bed_fields &f);
+  // the same, also giving the whole line, without its newline, which is
+  // valid until the next call to read
+  bool read(bed_fields &f, std::string_view &line);
+  bool read(GenomicRegion &r, std::string_view &line);
+  // replace the batch with up to max_regions regions, and give how many
+  size_t read(std::vector<GenomicRegion> &batch, const size_t max_regions);
+  size_t read(RegionTable &batch, const size_t max_regions);
+
+  // the number of lines read so far, including header lines
+  size_t get_line_number() const { return line_number; }
+
+  static const size_t default_buffer_size = 1 << 20;
+
+private:
+  bool next_line(std::string_view &line);
+  chrom_id_type get_chrom_id(const std::string_view chrom);
+
+  std::string filename;
+  gzFile in;
+  std::vector<char> buffer;
+  size_t pos;    // start of the unread part of the buffer
+  size_t filled; // end of the data in the buffer
+  bool at_eof;
+  size_t line_number;
+  std::string last_chrom;
+  chrom_id_type last_chrom_id;
+};
+
+/* BedWriter: writes regions in BED format, formatting each one directly
+ * into a buffer that is written out when full. The text is the same as
+ * from operator<< for the region: three columns, or six when the region
+ * has a name. If compress is true the output is compressed with gzip.
+ * Errors from the last writes are only seen by close(), which the
+ * destructor calls while ignoring them.
+ */
+class BedWriter {
+public:
+  explicit BedWriter(const std::string &filename, const bool compress = false,
+                     const size_t buffer_size = default_buffer_size);
+  ~BedWriter();
+  BedWriter(const BedWriter &) = delete;
+  BedWriter &operator=(const BedWriter &) = delete;
+
+  void write(const GenomicRegion &r);
+  void write(const SimpleGenomicRegion &r);
+  void write(const CompactRegion &r);
+  void write(const RegionTable &regions, const size_t i);
+  void write(const RegionTable &regions);
+  void write(const bedgraph_record &r);
+  // any other text, such as a track line; no newline is added
+  void write(const std::string_view text);
+
+  void flush();
+  void close();
+
+  static const size_t default_buffer_size = 1 << 20;
+
+private:
+  void write_fields(const std::string &chrom, const size_t start,
+                    const size_t end, const std::string_view name,
+                    const float score, const char strand);
+  char *reserve(const size_t n_bytes);
+  void write_out(const char *data, const size_t n_bytes);
+
+  std::string filename;
+  std::ofstream out;
+  std::unique_ptr<ogzfstream> gz_out;
+  std::vector<char> buffer;
+  size_t filled;
+};
+
+#endif
@@ -0,0 +1,128 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "bed_merge.hpp"
+#include "parallel_tasks.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::vector;
+
+BedMerger::BedMerger(const vector<string> &filenames, const size_t buffer_size)
+    : filenames(filenames), readers(filenames.size()),
+      current(filenames.size()), lines(filenames.size()),
+      done(filenames.size(), false),
+      tree(std::max<size_t>(filenames.size(), 1)), last_source(0) {
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    readers[i].reset(new BedReader(filenames[i], buffer_size));
+    string_view line;
+    done[i] = !readers[i]->read(current[i], line);
+    lines[i].assign(line);
+  }
+  if (!filenames.empty())
+    tree[0] = build(1);
+}
+
+// a file that is done loses to every other
+bool BedMerger::beats(const size_t a, const size_t b) const {
+  if (done[a] || done[b])
+    return !done[a];
+  return current[a] < current[b] || (!(current[b] < current[a]) && a < b);
+}
+
+// the nodes of a tree with k leaves are 1 to 2k - 1, and node k + i is
+// leaf i; the winner below a node is returned and the loser kept there
+size_t BedMerger::build(const size_t node) {
+  const size_t k = current.size();
+  if (node >= k)
+    return node - k;
+  const size_t left = build(2 * node);
+  const size_t right = build(2 * node + 1);
+  if (beats(left, right)) {
+    tree[node] = right;
+    return left;
+  }
+  tree[node] = left;
+  return right;
+}
+
+// read the next region of file i, and check it is not less than the
+// region before it
+bool BedMerger::advance(const size_t i, const GenomicRegion &previous) {
+  string_view line;
+  if (!readers[i]->read(current[i], line))
+    return false;
+  lines[i].assign(line);
+  if (current[i] < previous)
+    throw runtime_error("regions not sorted in " + filenames[i] +
+                        " at line " + to_string(readers[i]->get_line_number()));
+  return true;
+}
+
+bool BedMerger::read(GenomicRegion &r) {
+  if (current.empty())
+    return false;
+  const size_t w = tree[0];
+  if (done[w])
+    return false;
+  // the memory of r is reused for the next region of file w
+  r.swap(current[w]);
+  last_line.swap(lines[w]);
+  last_source = w;
+  done[w] = !advance(w, r);
+  // replay the matches on the path from leaf w to the root
+  size_t winner = w;
+  for (size_t node = (w + current.size()) / 2; node >= 1; node /= 2)
+    if (beats(tree[node], winner))
+      std::swap(tree[node], winner);
+  tree[0] = winner;
+  return true;
+}
+
+bool check_sorted_bed(const string &filename, size_t &line_number,
+                      GenomicRegion &region) {
+  BedReader in(filename);
+  GenomicRegion previous, r;
+  line_number = 0;
+  if (!in.read(previous))
+    return true;
+  while (in.read(r)) {
+    if (r < previous) {
+      line_number = in.get_line_number();
+      region.swap(r);
+      return false;
+    }
+    previous.swap(r);
+  }
+  return true;
+}
+
+void check_sorted_bed(const vector<string> &filenames,
+                      vector<size_t> &line_numbers,
+                      vector<GenomicRegion> &regions, const size_t n_threads) {
+  line_numbers.resize(filenames.size());
+  regions.resize(filenames.size());
+  run_tasks(filenames.size(), n_threads, [&](const size_t i) {
+    check_sorted_bed(filenames[i], line_numbers[i], regions[i]);
+  });
+}
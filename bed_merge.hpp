@@ -0,0 +1,77 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef BED_MERGE_HPP
+#define BED_MERGE_HPP
+
+#include "GenomicRegion.hpp"
+#include "bed_io.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* BedMerger: reads any number of BED files, each already sorted by
+ * GenomicRegion::operator<, as one sorted stream. Only the current
+ * region of each file is held, in a loser tree, so each region costs
+ * about log2(number of files) comparisons. Equal regions come from the
+ * file listed first. If a file turns out not to be sorted, read throws
+ * a runtime_error naming the file and line.
+ */
+class BedMerger {
+public:
+  explicit BedMerger(const std::vector<std::string> &filenames,
+                     const size_t buffer_size = BedReader::default_buffer_size);
+
+  // false once all files are done
+  bool read(GenomicRegion &r);
+  // the index of the file the last region came from
+  size_t get_source() const { return last_source; }
+  // the line of the last region, without its newline, as in its file
+  const std::string &get_line() const { return last_line; }
+
+private:
+  bool beats(const size_t a, const size_t b) const;
+  size_t build(const size_t node);
+  bool advance(const size_t i, const GenomicRegion &previous);
+
+  std::vector<std::string> filenames;
+  std::vector<std::unique_ptr<BedReader>> readers;
+  std::vector<GenomicRegion> current;
+  std::vector<std::string> lines; // of the current region of each file
+  std::vector<bool> done;
+  // tree[0] is the winner, and tree[n] the loser at node n of the tree
+  std::vector<size_t> tree;
+  size_t last_source;
+  std::string last_line;
+};
+
+/* Check whether the regions in a BED file are sorted, reading it as a
+ * stream. If not, gives the line number and the region of the first
+ * region that is less than the one before it.
+ */
+bool check_sorted_bed(const std::string &filename, size_t &line_number,
+                      GenomicRegion &region);
+
+/* The same for many files, checked in parallel. For each file that is
+ * sorted the line number is 0.
+ */
+void check_sorted_bed(const std::vector<std::string> &filenames,
+                      std::vector<size_t> &line_numbers,
+                      std::vector<GenomicRegion> &regions,
+                      const size_t n_threads = 1);
+
+#endif
@@ -0,0 +1,92 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+/* Times FeatureCounter::count on 1, 2, 4, ... threads, up to the given
+ * number, and gives the reads counted per second. The features are 20k
+ * genes of 5 exons on each of 20 chroms, and the reads are 100 bases at
+ * random places on those chroms, sorted as they would be in a BAM file,
+ * so some chunks of reads fall where there are more features.
+ *
+ * usage: feature_count_bench [n_reads] [max_threads]
+ */
+
+#include "FeatureCounter.hpp"
+#include "GenomicRegion.hpp"
+#include "MappedRead.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::size_t;
+using std::string;
+using std::to_string;
+using std::vector;
+
+int main(int argc, const char **argv) {
+  const size_t n_reads = argc > 1 ? std::atol(argv[1]) : 10000000;
+  const size_t max_threads =
+      argc > 2 ? std::atol(argv[2])
+               : std::max(1u, std::thread::hardware_concurrency());
+  static const size_t n_chroms = 20;
+  static const size_t n_exons = 100000;
+  static const size_t chrom_size = 50000000;
+  static const size_t read_size = 100;
+
+  std::mt19937_64 rng(1);
+  vector<GenomicRegion> features;
+  for (size_t c = 0; c < n_chroms; ++c) {
+    const string chrom = "chr" + to_string(c);
+    // exons at random gaps, denser at the start of each chrom
+    size_t pos = 0;
+    for (size_t i = 0; i < n_exons; ++i) {
+      pos += rng() % (1000 + i / 10);
+      features.emplace_back(chrom, pos, pos + 200 + rng() % 3000,
+                            "gene" + to_string(c * n_exons + i / 5), 0.0,
+                            "+-"[rng() % 2]);
+    }
+  }
+  std::sort(std::begin(features), std::end(features));
+  const FeatureCounter counter(features, true);
+
+  vector<MappedRead> reads(n_reads);
+  for (auto &r : reads) {
+    const size_t start = rng() % chrom_size;
+    r.r = GenomicRegion("chr" + to_string(rng() % n_chroms), start,
+                        start + read_size, "read", 0.0, "+-"[rng() % 2]);
+  }
+  std::sort(std::begin(reads), std::end(reads),
+            [](const MappedRead &a, const MappedRead &b) { return a.r < b.r; });
+
+  cout << features.size() << " exons, " << n_reads << " reads" << endl;
+  for (size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    vector<double> counts;
+    count_summary summary;
+    const auto start = std::chrono::steady_clock::now();
+    counter.count(reads, counts, summary, count_options(), n_threads);
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    cout << n_threads << " threads\t" << n_reads / seconds / 1e6
+         << "M reads/s\t" << summary.assigned << " assigned" << endl;
+  }
+}
@@ -0,0 +1,118 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+/* Times RegionSearch against the lower_bound path it replaces:
+ *  - contains, against std::lower_bound on the sorted starts;
+ *  - find_closest through a RegionSearch, against find_closest on the
+ *    sorted vector.
+ * Regions and lookup positions are random on one chrom, and each region
+ * is 1kb, so the two find_closest give answers at the same distance.
+ * Then one long region is added, which find_closest on the vector
+ * misses.
+ *
+ * usage: region_search_bench [n_regions] [n_lookups]
+ */
+
+#include "GenomicRegion.hpp"
+#include "RegionSearch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::size_t;
+using std::string;
+using std::vector;
+
+template <class F> static double seconds(F f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main(int argc, const char **argv) {
+  const size_t n_regions = argc > 1 ? std::atol(argv[1]) : 60000;
+  const size_t n_lookups = argc > 2 ? std::atol(argv[2]) : 10000000;
+  static const size_t chrom_size = 3000000000ul;
+  static const size_t region_size = 1000;
+
+  std::mt19937_64 rng(1);
+  vector<GenomicRegion> regions;
+  for (size_t i = 0; i < n_regions; ++i) {
+    const size_t start = rng() % chrom_size;
+    regions.emplace_back("chr1", start, start + region_size);
+  }
+  std::sort(std::begin(regions), std::end(regions));
+  vector<size_t> starts;
+  for (const auto &r : regions)
+    starts.push_back(r.get_start());
+  vector<GenomicRegion> queries;
+  for (size_t i = 0; i < n_lookups; ++i) {
+    const size_t pos = rng() % chrom_size;
+    queries.emplace_back("chr1", pos, pos + 1);
+  }
+  const chrom_id_type chrom = chrom_dict::assign("chr1");
+
+  RegionSearch search;
+  const double build_time = seconds([&] { search = RegionSearch(regions); });
+  cout << n_regions << " regions, " << n_lookups << " lookups" << endl
+       << "build RegionSearch\t" << build_time << "s" << endl;
+
+  size_t check = 0;
+  cout << "std::lower_bound\t" << seconds([&] {
+    for (const auto &q : queries)
+      check += std::lower_bound(std::begin(starts), std::end(starts),
+                                q.get_start()) -
+               std::begin(starts);
+  }) << "s" << endl;
+  cout << "contains\t\t" << seconds([&] {
+    for (const auto &q : queries)
+      check += search.contains(chrom, q.get_start());
+  }) << "s" << endl;
+
+  size_t n_differ = 0;
+  vector<size_t> closest(n_lookups);
+  cout << "find_closest, vector\t" << seconds([&] {
+    for (size_t i = 0; i < n_lookups; ++i)
+      closest[i] = queries[i].distance(*find_closest(regions, queries[i]));
+  }) << "s" << endl;
+  cout << "find_closest, search\t" << seconds([&] {
+    for (size_t i = 0; i < n_lookups; ++i)
+      n_differ += queries[i].distance(*find_closest(regions, search,
+                                                    queries[i])) != closest[i];
+  }) << "s" << endl;
+  cout << "different distances\t" << n_differ << endl;
+
+  // a region over half the chrom, behind many others
+  regions.emplace_back("chr1", 0, chrom_size / 2);
+  std::sort(std::begin(regions), std::end(regions));
+  search = RegionSearch(regions);
+  n_differ = 0;
+  for (const auto &q : queries) {
+    const auto a = find_closest(regions, q);
+    const auto b = find_closest(regions, search, q);
+    n_differ += q.distance(*a) != q.distance(*b);
+  }
+  cout << "one long region, nearer with search\t" << n_differ << endl;
+  return check == 0; // keeps the lookups from being optimized out
+}
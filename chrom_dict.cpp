@@ -0,0 +1,271 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "chrom_dict.hpp"
+#include "chromosome_utils.hpp"
+#include "string_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using std::atomic;
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::mutex;
+using std::string;
+using std::string_view;
+using std::unordered_map;
+using std::vector;
+
+// constructed on first use, so regions can be made during static init
+static StringPool &chrom_pool() {
+  static StringPool pool;
+  return pool;
+}
+
+chrom_id_type chrom_dict::assign(const string_view chrom) {
+  return chrom_pool().assign(chrom);
+}
+
+bool chrom_dict::find(const string_view chrom, chrom_id_type &id) {
+  uint32_t the_id = 0;
+  if (!chrom_pool().find(chrom, the_id))
+    return false;
+  id = the_id;
+  return true;
+}
+
+const string &chrom_dict::name(const chrom_id_type id) {
+  return chrom_pool().get(id);
+}
+
+size_t chrom_dict::size() { return chrom_pool().size(); }
+
+/* The rank of each chrom id is read under a sequence lock: a reader
+ * notes the sequence number, reads the ranks it needs, and tries again
+ * if the number has changed, so two ranks read together always come
+ * from the same ordering. Arrays of ranks are replaced when they fill,
+ * but kept until exit since a reader might still be using an old one.
+ */
+struct chrom_rank_table {
+  mutex write_mutex;
+  atomic<uint64_t> seq{0};
+  atomic<size_t> n_ranked{0};
+  atomic<atomic<uint32_t> *> ranks{nullptr};
+  vector<std::unique_ptr<atomic<uint32_t>[]>> arrays;
+  size_t capacity{0};
+  chrom_order order{chrom_order::lexicographic};
+  unordered_map<string, size_t> given; // position in a given order
+};
+
+static chrom_rank_table &rank_table() {
+  static chrom_rank_table t;
+  return t;
+}
+
+static bool natural_less(const string &a, const string &b) {
+  const size_t a_size = a.size(), b_size = b.size();
+  size_t i = 0, j = 0;
+  while (i < a_size && j < b_size) {
+    if (std::isdigit(a[i]) && std::isdigit(b[j])) {
+      // compare runs of digits by value, ignoring leading zeros
+      size_t i_end = i, j_end = j;
+      while (i_end < a_size && std::isdigit(a[i_end]))
+        ++i_end;
+      while (j_end < b_size && std::isdigit(b[j_end]))
+        ++j_end;
+      while (i + 1 < i_end && a[i] == '0')
+        ++i;
+      while (j + 1 < j_end && b[j] == '0')
+        ++j;
+      if (i_end - i != j_end - j)
+        return i_end - i < j_end - j;
+      const int c = a.compare(i, i_end - i, b, j, j_end - j);
+      if (c != 0)
+        return c < 0;
+      i = i_end;
+      j = j_end;
+    }
+    else {
+      if (a[i] != b[j])
+        return static_cast<unsigned char>(a[i]) <
+               static_cast<unsigned char>(b[j]);
+      ++i;
+      ++j;
+    }
+  }
+  if (i == a_size && j != b_size)
+    return true;
+  if (i != a_size && j == b_size)
+    return false;
+  return a < b; // for names like chr01 and chr1
+}
+
+static bool order_less(const chrom_rank_table &t, const string &a,
+                       const string &b) {
+  switch (t.order) {
+  case chrom_order::natural:
+    return natural_less(a, b);
+  case chrom_order::given: {
+    const auto a_pos = t.given.find(a);
+    const auto b_pos = t.given.find(b);
+    if (a_pos != end(t.given) && b_pos != end(t.given))
+      return a_pos->second < b_pos->second;
+    if (a_pos != end(t.given) || b_pos != end(t.given))
+      return a_pos != end(t.given);
+    return a < b;
+  }
+  default:
+    return a < b;
+  }
+}
+
+static void update_ranks(chrom_rank_table &t, const bool force) {
+  // must be called with the write lock held
+  StringPool &pool = chrom_pool();
+  const size_t n = pool.size();
+  if (!force && n <= t.n_ranked.load(memory_order_relaxed))
+    return;
+
+  vector<uint32_t> ids(n);
+  std::iota(begin(ids), end(ids), 0);
+  std::sort(begin(ids), end(ids), [&](const uint32_t a, const uint32_t b) {
+    return order_less(t, pool.get(a), pool.get(b));
+  });
+
+  atomic<uint32_t> *ranks = t.ranks.load(memory_order_relaxed);
+  if (n > t.capacity) {
+    t.capacity = std::max(2 * t.capacity, std::max(n, size_t{64}));
+    t.arrays.emplace_back(new atomic<uint32_t>[t.capacity]);
+    ranks = t.arrays.back().get();
+    for (size_t i = 0; i < t.capacity; ++i)
+      ranks[i].store(0, memory_order_relaxed);
+  }
+
+  const uint64_t s = t.seq.load(memory_order_relaxed);
+  t.seq.store(s + 1, memory_order_relaxed);
+  std::atomic_thread_fence(memory_order_release);
+  t.ranks.store(ranks, memory_order_release);
+  for (size_t i = 0; i < n; ++i)
+    ranks[ids[i]].store(i, memory_order_relaxed);
+  t.n_ranked.store(n, memory_order_relaxed);
+  t.seq.store(s + 2, memory_order_release);
+}
+
+static void read_ranks(const chrom_id_type a, const chrom_id_type b,
+                       uint32_t &a_rank, uint32_t &b_rank) {
+  assert(a < chrom_pool().size() && b < chrom_pool().size());
+  chrom_rank_table &t = rank_table();
+  for (;;) {
+    const uint64_t s = t.seq.load(memory_order_acquire);
+    if (s & 1) {
+      std::this_thread::yield(); // ranks are being updated
+      continue;
+    }
+    const size_t n = t.n_ranked.load(memory_order_relaxed);
+    if (a < n && b < n) {
+      const atomic<uint32_t> *ranks = t.ranks.load(memory_order_acquire);
+      a_rank = ranks[a].load(memory_order_relaxed);
+      b_rank = ranks[b].load(memory_order_relaxed);
+      std::atomic_thread_fence(memory_order_acquire);
+      if (t.seq.load(memory_order_relaxed) == s)
+        return;
+    }
+    else {
+      lock_guard<mutex> lock(t.write_mutex);
+      update_ranks(t, false);
+    }
+  }
+}
+
+uint32_t chrom_dict::rank(const chrom_id_type id) {
+  uint32_t r = 0, unused = 0;
+  read_ranks(id, id, r, unused);
+  return r;
+}
+
+void chrom_dict::get_ranks(vector<uint32_t> &ranks) {
+  chrom_rank_table &t = rank_table();
+  {
+    lock_guard<mutex> lock(t.write_mutex);
+    update_ranks(t, false);
+  }
+  for (;;) {
+    const uint64_t s = t.seq.load(memory_order_acquire);
+    if (s & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    const size_t n = t.n_ranked.load(memory_order_relaxed);
+    const atomic<uint32_t> *r = t.ranks.load(memory_order_acquire);
+    ranks.resize(n);
+    for (size_t i = 0; i < n; ++i)
+      ranks[i] = r[i].load(memory_order_relaxed);
+    std::atomic_thread_fence(memory_order_acquire);
+    if (t.seq.load(memory_order_relaxed) == s)
+      return;
+  }
+}
+
+bool chrom_dict::less(const chrom_id_type a, const chrom_id_type b) {
+  if (a == b)
+    return false;
+  uint32_t a_rank = 0, b_rank = 0;
+  read_ranks(a, b, a_rank, b_rank);
+  return a_rank < b_rank;
+}
+
+chrom_order chrom_dict::get_order() {
+  chrom_rank_table &t = rank_table();
+  lock_guard<mutex> lock(t.write_mutex);
+  return t.order;
+}
+
+void chrom_dict::set_order(const chrom_order order) {
+  chrom_rank_table &t = rank_table();
+  lock_guard<mutex> lock(t.write_mutex);
+  t.order = order;
+  update_ranks(t, true);
+}
+
+void chrom_dict::set_order(const vector<string> &chroms) {
+  chrom_rank_table &t = rank_table();
+  lock_guard<mutex> lock(t.write_mutex);
+  t.given.clear();
+  for (size_t i = 0; i < chroms.size(); ++i)
+    t.given.emplace(chroms[i], i); // the first listing counts
+  t.order = chrom_order::given;
+  update_ranks(t, true);
+}
+
+void chrom_dict::read_order(const string &chrom_sizes_file) {
+  vector<string> chroms;
+  vector<size_t> sizes;
+  read_chrom_sizes(chrom_sizes_file, chroms, sizes);
+  set_order(chroms);
+}
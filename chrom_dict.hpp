@@ -0,0 +1,66 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef CHROM_DICT_HPP
+#define CHROM_DICT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+typedef unsigned chrom_id_type;
+
+// how chroms are ordered when regions are compared
+enum class chrom_order {
+  lexicographic, // by name as strings; the default
+  natural,       // digits compared as numbers, so chr2 < chr10
+  given,         // as listed (e.g., from a chrom sizes file), then by name
+};
+
+/* The chromosome names used by GenomicRegion and SimpleGenomicRegion,
+ * with one id for each name shared by both classes. Any thread can add
+ * or look up names at any time; lookups do not lock.
+ *
+ * Each id also has a rank in the current chrom_order, which is what the
+ * region comparison operators use, so comparing regions on different
+ * chroms never touches the names. Ranks are recomputed when a chrom
+ * without one is first compared. Changing the order means vectors that
+ * were sorted before are no longer sorted.
+ */
+namespace chrom_dict {
+// the id of the chrom, adding it if new
+chrom_id_type assign(const std::string_view chrom);
+// the id of the chrom, if it has been seen
+bool find(const std::string_view chrom, chrom_id_type &id);
+const std::string &name(const chrom_id_type id);
+size_t size();
+
+uint32_t rank(const chrom_id_type id);
+// the ranks of all ids, indexed by id, all from the same ordering
+void get_ranks(std::vector<uint32_t> &ranks);
+// true if chrom a comes before chrom b in the current order
+bool less(const chrom_id_type a, const chrom_id_type b);
+
+chrom_order get_order();
+void set_order(const chrom_order order);
+// use the given order, with chroms not in the list after those that are
+void set_order(const std::vector<std::string> &chroms);
+// use the order of the chroms in a chrom sizes file
+void read_order(const std::string &chrom_sizes_file);
+} // namespace chrom_dict
+
+#endif
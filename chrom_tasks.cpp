@@ -0,0 +1,180 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "chrom_tasks.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// the number of pieces for a chrom of this weight
+static size_t n_pieces(const size_t weight, const size_t max_weight) {
+  return std::max<size_t>(1, (weight + max_weight - 1) / max_weight);
+}
+
+// the most weight for one task when the total is split into n_tasks
+static size_t max_task_weight(const size_t total_weight, size_t n_tasks) {
+  n_tasks = std::max<size_t>(n_tasks, 1);
+  return std::max<size_t>(1, (total_weight + n_tasks - 1) / n_tasks);
+}
+
+void make_chrom_tasks(const vector<chrom_id_type> &chroms,
+                      const vector<size_t> &starts, const vector<size_t> &ends,
+                      const size_t n_tasks, const chrom_task_balance balance,
+                      vector<size_t> &order, vector<chrom_task> &tasks) {
+  const size_t n = chroms.size();
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  order.resize(n);
+  std::iota(std::begin(order), std::end(order), 0);
+  std::stable_sort(std::begin(order), std::end(order),
+                   [&](const size_t a, const size_t b) {
+                     if (chroms[a] != chroms[b])
+                       return ranks[chroms[a]] < ranks[chroms[b]];
+                     return starts[a] < starts[b];
+                   });
+
+  // each chrom is [chrom_first, chrom_last) in the order
+  vector<size_t> chrom_first;
+  for (size_t i = 0; i < n; ++i)
+    if (i == 0 || chroms[order[i]] != chroms[order[i - 1]])
+      chrom_first.push_back(i);
+  chrom_first.push_back(n);
+  const size_t n_chroms = chrom_first.size() - 1;
+
+  vector<size_t> lengths(n_chroms, 0);
+  for (size_t c = 0; c < n_chroms; ++c)
+    for (size_t i = chrom_first[c]; i < chrom_first[c + 1]; ++i)
+      lengths[c] = std::max(lengths[c], ends[order[i]]);
+
+  const bool by_length = (balance == chrom_task_balance::chrom_length);
+  size_t total_weight = 0;
+  for (size_t c = 0; c < n_chroms; ++c)
+    total_weight +=
+        by_length ? lengths[c] : chrom_first[c + 1] - chrom_first[c];
+  const size_t max_weight = max_task_weight(total_weight, n_tasks);
+
+  tasks.clear();
+  for (size_t c = 0; c < n_chroms; ++c) {
+    const size_t first = chrom_first[c], last = chrom_first[c + 1];
+    const chrom_id_type chrom = chroms[order[first]];
+    const size_t length = std::max(lengths[c], starts[order[last - 1]] + 1);
+    const size_t weight = by_length ? lengths[c] : last - first;
+    const size_t p = n_pieces(weight, max_weight);
+    // the start positions where the pieces begin
+    vector<size_t> cuts(1, 0);
+    for (size_t k = 1; k < p; ++k) {
+      size_t cut = 0;
+      if (by_length)
+        cut = (length * k) / p;
+      else {
+        // cut before a region, but never between regions with equal starts
+        const size_t i = first + ((last - first) * k) / p;
+        cut = starts[order[i]];
+      }
+      if (cut > cuts.back())
+        cuts.push_back(cut);
+    }
+    cuts.push_back(length);
+    size_t i = first;
+    for (size_t k = 0; k + 1 < cuts.size(); ++k) {
+      chrom_task t;
+      t.chrom = chrom;
+      t.start = cuts[k];
+      t.end = cuts[k + 1];
+      t.first = i;
+      while (i < last && starts[order[i]] < t.end)
+        ++i;
+      t.last = i;
+      t.weight = by_length ? t.end - t.start : t.last - t.first;
+      tasks.push_back(t);
+    }
+  }
+}
+
+void make_chrom_tasks(const vector<string> &chrom_names,
+                      const vector<size_t> &chrom_sizes, const size_t n_tasks,
+                      vector<chrom_task> &tasks) {
+  if (chrom_names.size() != chrom_sizes.size())
+    throw runtime_error("different numbers of chrom names and sizes");
+  vector<chrom_id_type> chroms(chrom_names.size());
+  for (size_t i = 0; i < chrom_names.size(); ++i)
+    chroms[i] = chrom_dict::assign(chrom_names[i]);
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  vector<size_t> order(chroms.size());
+  std::iota(std::begin(order), std::end(order), 0);
+  std::stable_sort(std::begin(order), std::end(order),
+                   [&](const size_t a, const size_t b) {
+                     return ranks[chroms[a]] < ranks[chroms[b]];
+                   });
+
+  size_t total_weight = 0;
+  for (const auto s : chrom_sizes)
+    total_weight += s;
+  const size_t max_weight = max_task_weight(total_weight, n_tasks);
+
+  tasks.clear();
+  for (const auto c : order) {
+    const size_t length = chrom_sizes[c];
+    const size_t p = n_pieces(length, max_weight);
+    for (size_t k = 0; k < p; ++k) {
+      chrom_task t;
+      t.chrom = chroms[c];
+      t.start = (length * k) / p;
+      t.end = (length * (k + 1)) / p;
+      t.weight = t.end - t.start;
+      tasks.push_back(t);
+    }
+  }
+}
+
+void group_chrom_tasks(const vector<chrom_id_type> &chroms,
+                       vector<size_t> &order, vector<chrom_task> &tasks) {
+  // a stable counting sort by chrom id
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  vector<size_t> offsets(ranks.size() + 1, 0);
+  for (const auto c : chroms)
+    ++offsets[c + 1];
+  for (size_t c = 1; c < offsets.size(); ++c)
+    offsets[c] += offsets[c - 1];
+  order.resize(chroms.size());
+  vector<size_t> fill(std::begin(offsets), std::end(offsets) - 1);
+  for (size_t i = 0; i < chroms.size(); ++i)
+    order[fill[chroms[i]]++] = i;
+
+  tasks.clear();
+  for (size_t c = 0; c + 1 < offsets.size(); ++c)
+    if (offsets[c] < offsets[c + 1]) {
+      chrom_task t;
+      t.chrom = c;
+      t.first = offsets[c];
+      t.last = offsets[c + 1];
+      t.weight = t.last - t.first;
+      tasks.push_back(t);
+    }
+  std::sort(std::begin(tasks), std::end(tasks),
+            [&ranks](const chrom_task &a, const chrom_task &b) {
+              return ranks[a.chrom] < ranks[b.chrom];
+            });
+}
@@ -0,0 +1,127 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef CHROM_TASKS_HPP
+#define CHROM_TASKS_HPP
+
+#include "chrom_dict.hpp"
+#include "parallel_tasks.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <vector>
+
+/* Work on regions is split into tasks by chrom, and large chroms are
+ * split into several tasks, each for a range of positions. A task has
+ * the regions whose start is in [start, end) on its chrom, and they are
+ * at [first, last) in the order of regions made along with the tasks.
+ * Tasks are in chrom_dict order, then by position, and that order does
+ * not depend on the number of threads or on the order tasks finish.
+ */
+struct chrom_task {
+  chrom_id_type chrom{};
+  size_t start{};
+  size_t end{};
+  size_t first{};
+  size_t last{};
+  size_t weight{}; // number of regions or number of bases
+};
+
+enum class chrom_task_balance {
+  region_count, // each task has about the same number of regions
+  chrom_length, // each task covers about the same number of bases
+};
+
+/* Make tasks for regions given by their chroms, starts and ends. The
+ * indices of the regions, ordered by chrom and then start, go in order.
+ * Chroms are split so that no task is much more than the total weight
+ * divided by n_tasks. With chrom_length balance, the length of a chrom
+ * is the largest end of its regions. A region is only in the task that
+ * has its start, so callbacks that need regions overlapping the range
+ * of a task must look for them in neighbouring tasks.
+ */
+void make_chrom_tasks(const std::vector<chrom_id_type> &chroms,
+                      const std::vector<size_t> &starts,
+                      const std::vector<size_t> &ends, const size_t n_tasks,
+                      const chrom_task_balance balance,
+                      std::vector<size_t> &order,
+                      std::vector<chrom_task> &tasks);
+
+// the same for a vector of regions of any type
+template <class T>
+void make_chrom_tasks(const std::vector<T> &regions, const size_t n_tasks,
+                      std::vector<size_t> &order,
+                      std::vector<chrom_task> &tasks,
+                      const chrom_task_balance balance =
+                          chrom_task_balance::region_count) {
+  std::vector<chrom_id_type> chroms(regions.size());
+  std::vector<size_t> starts(regions.size()), ends(regions.size());
+  for (size_t i = 0; i < regions.size(); ++i) {
+    chroms[i] = regions[i].get_chrom_id();
+    starts[i] = regions[i].get_start();
+    ends[i] = regions[i].get_end();
+  }
+  make_chrom_tasks(chroms, starts, ends, n_tasks, balance, order, tasks);
+}
+
+/* Tasks that cover whole chroms of the given sizes, for work that reads
+ * its own data for each range, like from files. The chroms are added to
+ * chrom_dict, and first and last are 0 in every task.
+ */
+void make_chrom_tasks(const std::vector<std::string> &chrom_names,
+                      const std::vector<size_t> &chrom_sizes,
+                      const size_t n_tasks, std::vector<chrom_task> &tasks);
+
+/* One task for each chrom, without splitting, and without sorting by
+ * position. The indices of the regions, grouped by chrom and in their
+ * original order within each chrom, go in order.
+ */
+void group_chrom_tasks(const std::vector<chrom_id_type> &chroms,
+                       std::vector<size_t> &order,
+                       std::vector<chrom_task> &tasks);
+
+/* Call f(tasks[i], i) for every task using up to n_threads threads. The
+ * tasks with the most weight are started first, so a large chrom isn't
+ * left until the end. Callbacks that put their results at index i get
+ * them in task order whatever order the tasks finish.
+ */
+template <class F>
+void run_chrom_tasks(const std::vector<chrom_task> &tasks,
+                     const size_t n_threads, F f) {
+  std::vector<size_t> by_weight(tasks.size());
+  std::iota(std::begin(by_weight), std::end(by_weight), 0);
+  std::stable_sort(std::begin(by_weight), std::end(by_weight),
+                   [&tasks](const size_t a, const size_t b) {
+                     return tasks[a].weight > tasks[b].weight;
+                   });
+  run_tasks(tasks.size(), n_threads, [&](const size_t i) {
+    f(tasks[by_weight[i]], by_weight[i]);
+  });
+}
+
+// the same, putting the value of f(tasks[i]) in results[i]
+template <class R, class F>
+void run_chrom_tasks(const std::vector<chrom_task> &tasks,
+                     const size_t n_threads, F f, std::vector<R> &results) {
+  results.clear();
+  results.resize(tasks.size());
+  run_chrom_tasks(tasks, n_threads, [&](const chrom_task &t, const size_t i) {
+    results[i] = f(t);
+  });
+}
+
+#endif
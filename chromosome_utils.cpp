@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <iterator>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -232,3 +233,25 @@ void identify_and_read_chromosomes(const string chrom_file,
       chrom_files[names[j]] = the_files[i];
   }
 }
+
+void read_chrom_sizes(const string &filename, vector<string> &chroms,
+                      vector<size_t> &sizes) {
+  std::ifstream in(filename);
+  if (!in)
+    throw runtime_error("cannot open chrom sizes file: " + filename);
+  chroms.clear();
+  sizes.clear();
+  string line;
+  while (getline(in, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream iss(line);
+    string chrom;
+    size_t chrom_size = 0;
+    if (!(iss >> chrom >> chrom_size))
+      throw runtime_error("bad line in chrom sizes file " + filename + ":\n" +
+                          line);
+    chroms.push_back(chrom);
+    sizes.push_back(chrom_size);
+  }
+}
@@ -60,4 +60,10 @@ void identify_and_read_chromosomes(
     const std::string chrom_file, const std::string fasta_suffix,
     std::unordered_map<std::string, std::string> &chrom_files);
 
+// read a chrom sizes file (or a .fai index): the name and length from the
+// first two columns of each line, in the order they appear
+void read_chrom_sizes(const std::string &filename,
+                      std::vector<std::string> &chroms,
+                      std::vector<size_t> &sizes);
+
 #endif
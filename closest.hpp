@@ -0,0 +1,394 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef CLOSEST_HPP
+#define CLOSEST_HPP
+
+#include "chrom_dict.hpp"
+#include "chrom_tasks.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/* Batched nearest-target queries. Instead of one binary search for each
+ * query, as in find_closest, the queries are taken in sorted order and
+ * each chrom of targets is walked with a pointer that only moves
+ * forward, so the targets near consecutive queries stay in cache. The
+ * queries don't have to be sorted: if they aren't, an order of them is
+ * made first. The targets must be sorted.
+ */
+
+// marks a missing target index or distance in the output
+static const size_t closest_none = std::numeric_limits<size_t>::max();
+
+enum class closest_strand {
+  any,      // targets on either strand
+  same,     // only targets on the strand of the query
+  opposite, // only targets on the other strand
+};
+
+// upstream and downstream are relative to the strand of the query
+enum class closest_direction {
+  any,
+  upstream,
+  downstream,
+};
+
+struct closest_options {
+  size_t k{1};                       // how many targets for each query
+  size_t max_distance{closest_none}; // ignore targets further than this
+  closest_strand strand{closest_strand::any};
+  closest_direction direction{closest_direction::any};
+};
+
+/* The same distance as GenomicRegion::distance for regions on the same
+ * chrom: 0 if they overlap, otherwise one more than the gap between
+ * them.
+ */
+template <class T, class U>
+size_t region_distance(const T &a, const U &b) {
+  if (a.get_end() <= b.get_start())
+    return b.get_start() - a.get_end() + 1;
+  if (b.get_end() <= a.get_start())
+    return a.get_start() - b.get_end() + 1;
+  return 0;
+}
+
+template <class Q, class T>
+bool closest_accept(const Q &query, const T &target, const size_t distance,
+                    const closest_options &opts) {
+  const bool same = (query.get_strand() == target.get_strand());
+  if ((opts.strand == closest_strand::same && !same) ||
+      (opts.strand == closest_strand::opposite && same))
+    return false;
+  // overlapping targets are in both directions
+  if (opts.direction == closest_direction::any || distance == 0)
+    return true;
+  const bool is_left = target.get_end() <= query.get_start();
+  const bool upstream_is_left = query.get_strand() != '-';
+  return is_left ==
+         (upstream_is_left == (opts.direction == closest_direction::upstream));
+}
+
+/* The targets of each chrom in lanes: one lane with all of them, or
+ * with a strand filter one lane for each strand, so targets on the
+ * wrong strand are never looked at. Positions index the targets of all
+ * lanes in order, and max_ends[L] has the largest end in each aligned
+ * block of 2^L positions. The nearest targets to the left of a query are
+ * the ones with the largest ends, and the blocks find each of them in
+ * O(log n) steps, even past a long target that covers many others. The
+ * largest end up to each position in its lane shows in one step when
+ * there are no more.
+ */
+struct closest_lane {
+  char strand;
+  size_t first; // positions [first, last)
+  size_t last;
+};
+
+struct closest_lanes {
+  std::vector<size_t> targets; // the target at each position
+  std::vector<std::vector<size_t>> max_ends;
+  std::vector<size_t> prefix_max_ends; // from the start of the lane
+  std::vector<closest_lane> lanes;
+  // the lanes [first, last) of each chrom, by chrom id
+  std::vector<std::pair<size_t, size_t>> chrom_lanes;
+
+  // the last position in [lo, hi) whose target ends at or after min_end
+  size_t find_last(const size_t lo, size_t hi, const size_t min_end) const {
+    // usually no target before hi in the lane ends late enough
+    if (hi == lo || prefix_max_ends[hi - 1] < min_end)
+      return closest_none;
+    size_t level = 0;
+    bool moved = true;
+    while (hi > lo) {
+      // a block that ends at hi and starts at or after lo, twice as large
+      // after each move, so the nearest targets are looked at first
+      const auto fits = [&](const size_t l) {
+        return (hi >> l << l) == hi && hi - lo >= (size_t{1} << l);
+      };
+      if (moved && level + 1 < max_ends.size() && fits(level + 1))
+        ++level;
+      while (level > 0 && !fits(level))
+        --level;
+      if (max_ends[level][(hi >> level) - 1] < min_end) {
+        hi -= size_t{1} << level;
+        moved = true;
+      }
+      else if (level == 0)
+        return hi - 1;
+      else {
+        --level; // the right half first
+        moved = false;
+      }
+    }
+    return closest_none;
+  }
+};
+
+template <class T>
+void build_closest_lanes(const std::vector<T> &targets, const bool by_strand,
+                         const std::vector<std::pair<size_t, size_t>> &ranges,
+                         closest_lanes &lanes) {
+  lanes.chrom_lanes.assign(ranges.size(), std::pair<size_t, size_t>(0, 0));
+  lanes.targets.reserve(targets.size());
+  lanes.prefix_max_ends.reserve(targets.size());
+  std::vector<size_t> ends;
+  ends.reserve(targets.size());
+  for (size_t i = 0; i < targets.size();) {
+    const chrom_id_type c = targets[i].get_chrom_id();
+    const size_t t_last = ranges[c].second;
+    lanes.chrom_lanes[c].first = lanes.lanes.size();
+    // the strands, in the order they appear on the chrom
+    std::vector<char> strands(1, targets[i].get_strand());
+    for (size_t t = i; t < t_last && by_strand; ++t)
+      if (std::find(std::begin(strands), std::end(strands),
+                    targets[t].get_strand()) == std::end(strands))
+        strands.push_back(targets[t].get_strand());
+    for (const char strand : strands) {
+      closest_lane lane{strand, lanes.targets.size(), 0};
+      size_t max_end = 0;
+      for (size_t t = i; t < t_last; ++t)
+        if (!by_strand || targets[t].get_strand() == strand) {
+          lanes.targets.push_back(t);
+          ends.push_back(targets[t].get_end());
+          max_end = std::max(max_end, targets[t].get_end());
+          lanes.prefix_max_ends.push_back(max_end);
+        }
+      lane.last = lanes.targets.size();
+      lanes.lanes.push_back(lane);
+    }
+    lanes.chrom_lanes[c].second = lanes.lanes.size();
+    i = t_last;
+  }
+  lanes.max_ends.clear();
+  lanes.max_ends.push_back(std::move(ends));
+  while (lanes.max_ends.back().size() > 1) {
+    const std::vector<size_t> &prev = lanes.max_ends.back();
+    std::vector<size_t> next(prev.size() / 2);
+    for (size_t b = 0; b < next.size(); ++b)
+      next[b] = std::max(prev[2 * b], prev[2 * b + 1]);
+    lanes.max_ends.push_back(std::move(next));
+  }
+}
+
+/* The queries at positions [first, last) of the sorted order, all on
+ * chrom. In each lane, the targets to the right of a query are walked
+ * until they are further than the k closest so far, and those to the
+ * left are found from their ends. A side that the direction excludes is
+ * only searched for targets that overlap the query.
+ */
+template <class Q, class T>
+void closest_in_range(const std::vector<Q> &queries,
+                      const std::vector<size_t> &order, const size_t first,
+                      const size_t last, const std::vector<T> &targets,
+                      const closest_lanes &lanes, const chrom_id_type chrom,
+                      const closest_options &opts,
+                      std::vector<size_t> &closest_idx,
+                      std::vector<size_t> &closest_dist) {
+  typedef std::pair<size_t, size_t> dist_idx;
+  std::vector<dist_idx> best; // a max-heap of the k closest so far
+  best.reserve(opts.k + 1);
+
+  const auto try_add = [&](const size_t d, const size_t t) {
+    if (best.size() < opts.k) {
+      best.emplace_back(d, t);
+      std::push_heap(std::begin(best), std::end(best));
+    }
+    else if (dist_idx(d, t) < best.front()) {
+      std::pop_heap(std::begin(best), std::end(best));
+      best.back() = dist_idx(d, t);
+      std::push_heap(std::begin(best), std::end(best));
+    }
+  };
+  const auto bound = [&]() {
+    return best.size() < opts.k ? opts.max_distance : best.front().first;
+  };
+  const auto start_at = [&](const size_t i) {
+    return targets[lanes.targets[i]].get_start();
+  };
+
+  // in each lane, the first target that does not start before the query
+  const size_t lane_first = lanes.chrom_lanes[chrom].first;
+  std::vector<size_t> p(lanes.chrom_lanes[chrom].second - lane_first);
+  for (size_t l = 0; l < p.size() && first < last; ++l) {
+    const size_t s = queries[order.empty() ? first : order[first]].get_start();
+    size_t lo = lanes.lanes[lane_first + l].first;
+    size_t hi = lanes.lanes[lane_first + l].last;
+    while (lo < hi) {
+      const size_t mid = lo + (hi - lo) / 2;
+      if (start_at(mid) < s)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    p[l] = lo;
+  }
+
+  for (size_t j = first; j < last; ++j) {
+    const size_t qi = order.empty() ? j : order[j];
+    const Q &q = queries[qi];
+    const size_t q_start = q.get_start(), q_end = q.get_end();
+    bool left_ok = true, right_ok = true;
+    if (opts.direction != closest_direction::any) {
+      left_ok = (q.get_strand() != '-') ==
+                (opts.direction == closest_direction::upstream);
+      right_ok = !left_ok;
+    }
+    const auto consider = [&](const size_t t) {
+      const size_t d = region_distance(q, targets[t]);
+      if (d <= opts.max_distance && closest_accept(q, targets[t], d, opts))
+        try_add(d, t);
+    };
+
+    best.clear();
+    for (size_t l = 0; l < p.size(); ++l) {
+      const closest_lane &lane = lanes.lanes[lane_first + l];
+      const bool same = (lane.strand == q.get_strand());
+      if (opts.strand != closest_strand::any &&
+          same != (opts.strand == closest_strand::same))
+        continue;
+      while (p[l] < lane.last && start_at(p[l]) < q_start)
+        ++p[l];
+      // to the right, distances never decrease
+      for (size_t i = p[l]; i < lane.last; ++i) {
+        const size_t s = start_at(i);
+        const size_t min_d = s < q_end ? 0 : s - q_end + 1;
+        if (min_d > bound() || (!right_ok && min_d > 0 && s != q_start))
+          break;
+        consider(lanes.targets[i]);
+      }
+      // to the left, the distance depends only on the end
+      for (size_t i = p[l];;) {
+        const size_t d = left_ok ? bound() : 0;
+        i = lanes.find_last(lane.first, i, d > q_start ? 0 : q_start - d + 1);
+        if (i == closest_none)
+          break;
+        consider(lanes.targets[i]);
+      }
+    }
+
+    std::sort_heap(std::begin(best), std::end(best));
+    const size_t offset = qi * opts.k;
+    for (size_t i = 0; i < opts.k; ++i) {
+      closest_idx[offset + i] = i < best.size() ? best[i].second : closest_none;
+      closest_dist[offset + i] = i < best.size() ? best[i].first : closest_none;
+    }
+  }
+}
+
+/* For each query, the indices of and distances to the k closest targets
+ * on the same chrom, closest first and ties broken by target index. The
+ * results for query i are at [i*k, (i+1)*k) in closest_idx and
+ * closest_dist, and where fewer than k targets qualify the rest are
+ * closest_none. The output vectors are resized only if they are not
+ * already queries.size()*k. Targets must be sorted as by operator<. Both
+ * types need get_chrom_id, get_start, get_end and get_strand.
+ */
+template <class Q, class T>
+void find_closest_all(const std::vector<Q> &queries,
+                      const std::vector<T> &targets,
+                      std::vector<size_t> &closest_idx,
+                      std::vector<size_t> &closest_dist,
+                      const closest_options &opts = closest_options(),
+                      const size_t n_threads = 1) {
+  if (opts.k == 0)
+    throw std::runtime_error("number of closest targets must be positive");
+  closest_idx.resize(queries.size() * opts.k);
+  closest_dist.resize(queries.size() * opts.k);
+
+  std::vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  const auto key_less = [&ranks](const chrom_id_type a_chrom,
+                                 const size_t a_start,
+                                 const chrom_id_type b_chrom,
+                                 const size_t b_start) {
+    return ranks[a_chrom] < ranks[b_chrom] ||
+           (a_chrom == b_chrom && a_start < b_start);
+  };
+
+  // the targets of each chrom, which must be sorted
+  std::vector<std::pair<size_t, size_t>> chrom_targets(ranks.size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    const chrom_id_type c = targets[i].get_chrom_id();
+    if (i > 0 && key_less(c, targets[i].get_start(),
+                          targets[i - 1].get_chrom_id(),
+                          targets[i - 1].get_start()))
+      throw std::runtime_error("targets are not sorted");
+    if (i == 0 || c != targets[i - 1].get_chrom_id())
+      chrom_targets[c].first = i;
+    chrom_targets[c].second = i + 1;
+  }
+  closest_lanes lanes;
+  build_closest_lanes(targets, opts.strand != closest_strand::any,
+                      chrom_targets, lanes);
+
+  // an order of the queries, left empty if they are already sorted
+  std::vector<size_t> order;
+  for (size_t i = 1; i < queries.size() && order.empty(); ++i)
+    if (key_less(queries[i].get_chrom_id(), queries[i].get_start(),
+                 queries[i - 1].get_chrom_id(), queries[i - 1].get_start())) {
+      order.resize(queries.size());
+      std::iota(std::begin(order), std::end(order), 0);
+      std::stable_sort(std::begin(order), std::end(order),
+                       [&](const size_t a, const size_t b) {
+                         return key_less(queries[a].get_chrom_id(),
+                                         queries[a].get_start(),
+                                         queries[b].get_chrom_id(),
+                                         queries[b].get_start());
+                       });
+    }
+  const auto query_at = [&](const size_t j) -> const Q & {
+    return queries[order.empty() ? j : order[j]];
+  };
+
+  // tasks are pieces of the runs of queries on each chrom
+  const size_t n = queries.size();
+  const size_t n_workers = std::max<size_t>(1, n_threads);
+  const size_t piece_size =
+      std::max<size_t>(1, (n + 4 * n_workers - 1) / (4 * n_workers));
+  std::vector<chrom_task> tasks;
+  for (size_t a = 0; a < n;) {
+    const chrom_id_type c = query_at(a).get_chrom_id();
+    size_t b = a + 1;
+    while (b < n && query_at(b).get_chrom_id() == c)
+      ++b;
+    for (size_t i = a; i < b; i += piece_size) {
+      chrom_task t;
+      t.chrom = c;
+      t.first = i;
+      t.last = std::min(b, i + piece_size);
+      t.start = query_at(t.first).get_start();
+      t.end = query_at(t.last - 1).get_start() + 1;
+      t.weight = t.last - t.first;
+      tasks.push_back(t);
+    }
+    a = b;
+  }
+
+  run_chrom_tasks(tasks, n_threads, [&](const chrom_task &t, const size_t) {
+    closest_in_range(queries, order, t.first, t.last, targets, lanes, t.chrom,
+                     opts, closest_idx, closest_dist);
+  });
+}
+
+#endif
@@ -0,0 +1,238 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "coverage.hpp"
+#include "chrom_tasks.hpp"
+#include "smithlab_os.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// add a run, joining it to the last one if they touch and have equal depth
+static void add_run(vector<bedgraph_record> &runs, const chrom_id_type chrom,
+                    const size_t start, const size_t end, const size_t depth) {
+  if (depth == 0 || start >= end)
+    return;
+  if (!runs.empty() && runs.back().end == start &&
+      runs.back().value == depth)
+    runs.back().end = end;
+  else
+    runs.push_back({chrom, start, end, static_cast<double>(depth)});
+}
+
+// the regions idx[0..n) are sorted by start
+static void sweep_coverage(const vector<size_t> &starts,
+                           const vector<size_t> &ends, const size_t *idx,
+                           const size_t n, const chrom_id_type chrom,
+                           vector<bedgraph_record> &runs) {
+  std::priority_queue<size_t, vector<size_t>, std::greater<size_t>> open_ends;
+  size_t pos = 0, depth = 0;
+  const auto close_before = [&](const size_t limit) {
+    while (!open_ends.empty() && open_ends.top() <= limit) {
+      const size_t e = open_ends.top();
+      open_ends.pop();
+      add_run(runs, chrom, pos, e, depth);
+      pos = std::max(pos, e);
+      --depth;
+    }
+  };
+  for (size_t k = 0; k < n; ++k) {
+    const size_t s = starts[idx[k]], e = ends[idx[k]];
+    if (s >= e)
+      continue;
+    close_before(s);
+    add_run(runs, chrom, pos, s, depth);
+    pos = s;
+    ++depth;
+    open_ends.push(e);
+  }
+  close_before(std::numeric_limits<size_t>::max());
+}
+
+// the changes in depth at each base of [lo, hi)
+static void diff_array_coverage(const vector<size_t> &starts,
+                                const vector<size_t> &ends, const size_t *idx,
+                                const size_t n, const chrom_id_type chrom,
+                                const size_t lo, const size_t hi,
+                                vector<bedgraph_record> &runs) {
+  // depths fit in 32 bits, so changes can wrap around and still add up
+  vector<uint32_t> diff(hi - lo + 1, 0);
+  for (size_t k = 0; k < n; ++k) {
+    const size_t s = starts[idx[k]], e = ends[idx[k]];
+    if (s < e) {
+      ++diff[s - lo];
+      --diff[e - lo];
+    }
+  }
+  uint32_t depth = 0;
+  size_t run_start = lo;
+  for (size_t x = 0; x < diff.size(); ++x)
+    if (diff[x] != 0) {
+      add_run(runs, chrom, run_start, lo + x, depth);
+      run_start = lo + x;
+      depth += diff[x];
+    }
+}
+
+void compute_coverage(const vector<chrom_id_type> &chroms,
+                      const vector<size_t> &starts, const vector<size_t> &ends,
+                      vector<bedgraph_record> &runs, const size_t n_threads) {
+  const size_t n = chroms.size();
+  if (starts.size() != n || ends.size() != n)
+    throw runtime_error("different numbers of chroms, starts and ends");
+
+  // group by chrom, keeping the order within each chrom
+  vector<size_t> order;
+  vector<chrom_task> tasks;
+  group_chrom_tasks(chroms, order, tasks);
+
+  vector<vector<bedgraph_record>> chrom_runs;
+  run_chrom_tasks(
+      tasks, n_threads,
+      [&](const chrom_task &t) {
+        vector<bedgraph_record> r;
+        size_t *idx = order.data() + t.first;
+        const size_t m = t.last - t.first;
+        size_t lo = std::numeric_limits<size_t>::max(), hi = 0;
+        bool sorted = true;
+        for (size_t k = 0; k < m; ++k) {
+          lo = std::min(lo, starts[idx[k]]);
+          hi = std::max(hi, ends[idx[k]]);
+          sorted = sorted && (k == 0 || starts[idx[k - 1]] <= starts[idx[k]]);
+        }
+        // an array of changes costs 4 bytes a base; sorting about 32 a region
+        if (sorted)
+          sweep_coverage(starts, ends, idx, m, t.chrom, r);
+        else if (hi > lo && hi - lo <= 8 * m)
+          diff_array_coverage(starts, ends, idx, m, t.chrom, lo, hi, r);
+        else {
+          // each task has its own part of order
+          std::stable_sort(idx, idx + m, [&](const size_t a, const size_t b) {
+            return starts[a] < starts[b];
+          });
+          sweep_coverage(starts, ends, idx, m, t.chrom, r);
+        }
+        return r;
+      },
+      chrom_runs);
+
+  runs.clear();
+  for (const auto &r : chrom_runs)
+    runs.insert(std::end(runs), std::begin(r), std::end(r));
+}
+
+void compute_coverage(const vector<MappedRead> &reads,
+                      vector<bedgraph_record> &runs, const size_t n_threads) {
+  vector<chrom_id_type> chroms(reads.size());
+  vector<size_t> starts(reads.size()), ends(reads.size());
+  for (size_t i = 0; i < reads.size(); ++i) {
+    chroms[i] = reads[i].r.get_chrom_id();
+    starts[i] = reads[i].r.get_start();
+    ends[i] = reads[i].r.get_end();
+  }
+  compute_coverage(chroms, starts, ends, runs, n_threads);
+}
+
+void depth_histogram(const vector<bedgraph_record> &runs,
+                     vector<size_t> &histogram, const size_t genome_size) {
+  histogram.assign(1, 0);
+  size_t covered = 0;
+  for (const auto &r : runs) {
+    const size_t depth = static_cast<size_t>(r.value);
+    if (histogram.size() <= depth)
+      histogram.resize(depth + 1, 0);
+    histogram[depth] += r.end - r.start;
+    covered += r.end - r.start;
+  }
+  if (genome_size > covered)
+    histogram[0] += genome_size - covered;
+}
+
+void window_mean_depth(const vector<bedgraph_record> &runs,
+                       const size_t window_size,
+                       vector<bedgraph_record> &windows,
+                       const vector<string> &chrom_names,
+                       const vector<size_t> &chrom_sizes) {
+  if (window_size == 0)
+    throw runtime_error("window size must be positive");
+  if (chrom_names.size() != chrom_sizes.size())
+    throw runtime_error("different numbers of chrom names and sizes");
+
+  // the chroms to cover, with their sizes
+  vector<bedgraph_record> chroms;
+  if (chrom_names.empty()) {
+    for (const auto &r : runs)
+      if (chroms.empty() || chroms.back().chrom != r.chrom)
+        chroms.push_back({r.chrom, 0, r.end, 0});
+      else
+        chroms.back().end = std::max(chroms.back().end, r.end);
+  }
+  else
+    for (size_t i = 0; i < chrom_names.size(); ++i)
+      chroms.push_back(
+          {chrom_dict::assign(chrom_names[i]), 0, chrom_sizes[i], 0});
+  std::stable_sort(std::begin(chroms), std::end(chroms),
+                   [](const bedgraph_record &a, const bedgraph_record &b) {
+                     return chrom_dict::less(a.chrom, b.chrom);
+                   });
+
+  // the runs of each chrom, which are together and sorted by start
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  vector<std::pair<size_t, size_t>> chrom_runs(ranks.size(), {0, 0});
+  for (size_t i = 0; i < runs.size(); ++i) {
+    if (i == 0 || runs[i].chrom != runs[i - 1].chrom)
+      chrom_runs[runs[i].chrom].first = i;
+    chrom_runs[runs[i].chrom].second = i + 1;
+  }
+
+  windows.clear();
+  for (const auto &c : chroms) {
+    size_t r = chrom_runs[c.chrom].first;
+    const size_t last = chrom_runs[c.chrom].second;
+    for (size_t ws = 0; ws < c.end; ws += window_size) {
+      const size_t we = std::min(ws + window_size, c.end);
+      while (r < last && runs[r].end <= ws)
+        ++r;
+      double sum = 0.0;
+      for (size_t k = r; k < last && runs[k].start < we; ++k)
+        sum += runs[k].value *
+               (std::min(runs[k].end, we) - std::max(runs[k].start, ws));
+      windows.push_back({c.chrom, ws, we, sum / (we - ws)});
+    }
+  }
+}
+
+void write_bedgraph(const string &filename,
+                    const vector<bedgraph_record> &records,
+                    const string &track_name) {
+  BedWriter out(filename, has_gz_ext(filename));
+  if (!track_name.empty())
+    out.write("track type=bedGraph name=" + track_name + "\n");
+  for (const auto &r : records)
+    out.write(r);
+  out.close();
+}
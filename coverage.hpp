@@ -0,0 +1,87 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef COVERAGE_HPP
+#define COVERAGE_HPP
+
+#include "MappedRead.hpp"
+#include "bed_io.hpp"
+#include "chrom_dict.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/* The depth of a set of regions at each base, as runs of equal depth in
+ * bedGraph form. Runs of depth 0 are left out, and runs next to each
+ * other always have different depths. The runs are in chrom_dict order.
+ *
+ * Each chrom is done on its own, and chroms are done in parallel. If
+ * the regions of a chrom are sorted by start, a sweep keeps the ends of
+ * the regions covering the current base in a heap. Otherwise, if the
+ * regions are dense enough on the chrom, the depth comes from an array
+ * of the changes at each base; for sparse regions that would be too
+ * large, so the regions are sorted and swept. Empty regions are
+ * ignored.
+ */
+void compute_coverage(const std::vector<chrom_id_type> &chroms,
+                      const std::vector<size_t> &starts,
+                      const std::vector<size_t> &ends,
+                      std::vector<bedgraph_record> &runs,
+                      const size_t n_threads = 1);
+
+// the same for vectors of regions, or of reads
+template <class T>
+void compute_coverage(const std::vector<T> &regions,
+                      std::vector<bedgraph_record> &runs,
+                      const size_t n_threads = 1) {
+  std::vector<chrom_id_type> chroms(regions.size());
+  std::vector<size_t> starts(regions.size()), ends(regions.size());
+  for (size_t i = 0; i < regions.size(); ++i) {
+    chroms[i] = regions[i].get_chrom_id();
+    starts[i] = regions[i].get_start();
+    ends[i] = regions[i].get_end();
+  }
+  compute_coverage(chroms, starts, ends, runs, n_threads);
+}
+
+void compute_coverage(const std::vector<MappedRead> &reads,
+                      std::vector<bedgraph_record> &runs,
+                      const size_t n_threads = 1);
+
+/* The number of bases at each depth. If genome_size is more than the
+ * number of bases covered, the rest are counted at depth 0.
+ */
+void depth_histogram(const std::vector<bedgraph_record> &runs,
+                     std::vector<size_t> &histogram,
+                     const size_t genome_size = 0);
+
+/* The mean depth in windows of the given size along each chrom, the
+ * last window of a chrom being shorter. Given chrom names and sizes,
+ * the windows cover those chroms; otherwise they cover each chrom with
+ * runs up to its last covered base.
+ */
+void window_mean_depth(const std::vector<bedgraph_record> &runs,
+                       const size_t window_size,
+                       std::vector<bedgraph_record> &windows,
+                       const std::vector<std::string> &chrom_names = {},
+                       const std::vector<size_t> &chrom_sizes = {});
+
+// write records as a bedGraph file, compressed if the name ends in ".gz"
+void write_bedgraph(const std::string &filename,
+                    const std::vector<bedgraph_record> &records,
+                    const std::string &track_name = "");
+
+#endif
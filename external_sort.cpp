@@ -0,0 +1,214 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "external_sort.hpp"
+#include "GenomicRegion.hpp"
+#include "bed_io.hpp"
+#include "bed_merge.hpp"
+#include "parallel_sort.hpp"
+#include "smithlab_os.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::unique_ptr;
+using std::vector;
+
+// the most runs that are merged at once
+static const size_t max_merge_fan_in = 64;
+
+/* A directory for the runs of one sort, removed along with the runs
+ * when the sort is done.
+ */
+struct sort_scratch {
+  explicit sort_scratch(string parent) {
+    if (parent.empty()) {
+      const char *tmpdir = std::getenv("TMPDIR");
+      parent = (tmpdir != nullptr && *tmpdir != '\0') ? tmpdir : "/tmp";
+    }
+    string pattern = path_join(parent, "smithlab_sort_XXXXXX");
+    if (mkdtemp(&pattern[0]) == nullptr)
+      throw runtime_error("failed to make scratch directory in " + parent);
+    dirname = pattern;
+  }
+  ~sort_scratch() {
+    for (const auto &f : files)
+      std::remove(f.c_str());
+    rmdir(dirname.c_str());
+  }
+  string new_file() {
+    files.push_back(path_join(dirname, "run" + to_string(files.size()) +
+                                           ".bed.gz"));
+    return files.back();
+  }
+  string dirname;
+  vector<string> files;
+};
+
+/* A line of the input, kept as text, with the fields it is sorted by.
+ * The text of all lines in a run is in one buffer.
+ */
+struct sort_line {
+  size_t start;
+  size_t end;
+  size_t offset; // of the line in the buffer of the run
+  size_t length;
+  chrom_id_type chrom;
+  char strand;
+};
+
+// the lines of a run, and room for more
+struct sort_run {
+  sort_run(const size_t text_bytes, const size_t max_lines) {
+    text.reserve(text_bytes);
+    lines.reserve(std::max<size_t>(max_lines, 1));
+  }
+  // false if the line doesn't fit in the memory reserved for the run
+  bool add(const GenomicRegion &r, const string_view line) {
+    // a line longer than the buffer is only taken into an empty run
+    if (!lines.empty() && (lines.size() == lines.capacity() ||
+                           text.size() + line.size() > text.capacity()))
+      return false;
+    lines.push_back({r.get_start(), r.get_end(), text.size(), line.size(),
+                     r.get_chrom_id(), r.get_strand()});
+    text.insert(std::end(text), std::begin(line), std::end(line));
+    return true;
+  }
+  void clear() {
+    text.clear();
+    lines.clear();
+  }
+  vector<char> text;
+  vector<sort_line> lines;
+};
+
+// the same order as GenomicRegion::operator<
+static void sort_lines(sort_run &run, const size_t n_threads) {
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+  parallel_stable_sort(std::begin(run.lines), std::end(run.lines),
+                       [&ranks](const sort_line &a, const sort_line &b) {
+                         if (a.chrom != b.chrom)
+                           return ranks[a.chrom] < ranks[b.chrom];
+                         return a.start < b.start ||
+                                (a.start == b.start &&
+                                 (a.end < b.end ||
+                                  (a.end == b.end && a.strand < b.strand)));
+                       },
+                       n_threads);
+}
+
+static void write_run(const sort_run &run, const string &filename,
+                      const bool compress) {
+  BedWriter out(filename, compress);
+  for (const auto &l : run.lines) {
+    out.write(string_view(run.text.data() + l.offset, l.length));
+    out.write("\n");
+  }
+  out.close();
+}
+
+/* Merge sorted runs into one output. Equal regions are taken from the
+ * earlier run first, so a stable sort of each run gives a stable sort
+ * of the whole input. Lines are copied as they are in the runs.
+ */
+static void merge_runs(const vector<string> &runs, const string &filename,
+                       const bool compress, const size_t buffer_size) {
+  BedMerger merger(runs, buffer_size);
+  BedWriter out(filename, compress);
+  GenomicRegion r;
+  while (merger.read(r)) {
+    out.write(merger.get_line());
+    out.write("\n");
+  }
+  out.close();
+}
+
+void sort_bed_file(const string &input_filename, const string &output_filename,
+                   const size_t max_memory, const string &scratch_dir,
+                   const size_t n_threads) {
+  // half the memory is for the text of a run and an eighth for the
+  // fields of its lines, both reserved at the start so no run grows
+  // past its share; parallel_stable_sort takes up to as many fields
+  // again for std::stable_sort in each thread, and as many again for
+  // merging the runs of the threads, which leaves an eighth for the
+  // buffers of reading and writing
+  const size_t text_bytes = std::max<size_t>(max_memory / 2, 1);
+  const size_t max_lines = max_memory / (8 * sizeof(sort_line));
+  const bool compress_output = has_gz_ext(output_filename);
+
+  BedReader in(input_filename);
+  unique_ptr<sort_scratch> scratch;
+  vector<string> runs;
+  sort_run run(text_bytes, max_lines);
+  GenomicRegion r;
+  string_view line;
+  bool more = in.read(r, line);
+  while (more) {
+    run.clear();
+    while (more && run.add(r, line))
+      more = in.read(r, line);
+    sort_lines(run, n_threads);
+    if (!more && runs.empty()) {
+      // everything fit in memory
+      write_run(run, output_filename, compress_output);
+      return;
+    }
+    if (!scratch)
+      scratch.reset(new sort_scratch(scratch_dir));
+    runs.push_back(scratch->new_file());
+    write_run(run, runs.back(), true);
+  }
+  if (runs.empty()) {
+    // no regions in the input
+    write_run(run, output_filename, compress_output);
+    return;
+  }
+  run = sort_run(0, 0);
+
+  // input buffers share the memory; more than 1 MB each helps little
+  const size_t buffer_size = std::clamp<size_t>(
+      max_memory / (2 * max_merge_fan_in), 1 << 16, 1 << 20);
+  while (runs.size() > max_merge_fan_in) {
+    // merge groups of consecutive runs, so the order among equal regions
+    // stays that of the runs
+    vector<string> merged_runs;
+    for (size_t i = 0; i < runs.size(); i += max_merge_fan_in) {
+      const size_t group_end = std::min(runs.size(), i + max_merge_fan_in);
+      const vector<string> group(std::begin(runs) + i,
+                                 std::begin(runs) + group_end);
+      merged_runs.push_back(scratch->new_file());
+      merge_runs(group, merged_runs.back(), true, buffer_size);
+      for (const auto &f : group)
+        std::remove(f.c_str());
+    }
+    std::swap(runs, merged_runs);
+  }
+  merge_runs(runs, output_filename, compress_output, buffer_size);
+}
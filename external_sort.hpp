@@ -0,0 +1,48 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef EXTERNAL_SORT_HPP
+#define EXTERNAL_SORT_HPP
+
+#include <cstddef>
+#include <string>
+
+static const size_t default_sort_memory = 1ul << 30;
+
+/* Sort a BED file that might not fit in memory, into the order of
+ * GenomicRegion::operator<. Each line is kept as text, and copied to
+ * the output unchanged, with only the fields it is sorted by parsed.
+ * Lines are read until their text fills half of max_memory, or their
+ * fields an eighth (sorting them takes up to two eighths more), and each
+ * such run is sorted with parallel_stable_sort on n_threads threads and
+ * written, compressed with gzip, to a new directory in scratch_dir. The
+ * runs are then merged, many at a time, until one is left, which is
+ * written to the output. Regions that compare equal stay in input
+ * order. If the whole input fits in one run, nothing is written to
+ * scratch_dir.
+ *
+ * The input can be compressed with gzip, and the output is compressed
+ * if its name ends in ".gz". Header lines in the input are not copied
+ * to the output. If scratch_dir is empty, the directory in the TMPDIR
+ * environment variable is used, or /tmp if that is not set. Scratch
+ * files are removed when done, even if there is an error.
+ */
+void sort_bed_file(const std::string &input_filename,
+                   const std::string &output_filename,
+                   const size_t max_memory = default_sort_memory,
+                   const std::string &scratch_dir = "",
+                   const size_t n_threads = 1);
+
+#endif
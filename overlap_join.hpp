@@ -0,0 +1,167 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef OVERLAP_JOIN_HPP
+#define OVERLAP_JOIN_HPP
+
+#include "MappedRead.hpp"
+#include "chrom_dict.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Every overlapping pair of a query and a feature, like reads and
+ * genes, found in one sweep over both sorted inputs. Unlike
+ * separate_regions, features can overlap each other. Only the features
+ * that might still overlap a later query are kept while sweeping: those
+ * that haven't ended before the current query, and those that start
+ * inside it. The result is pairs of indices into the two inputs, so no
+ * region is copied.
+ *
+ * Here regions overlap if they share at least one base, so empty
+ * regions overlap nothing.
+ */
+
+enum class overlap_strand {
+  any,      // features on either strand
+  same,     // only features on the strand of the query
+  opposite, // only features on the other strand
+};
+
+struct overlap_options {
+  // the overlap must cover at least this fraction of the query, and of
+  // the feature; with 0, any overlap of one base or more
+  double min_query_fraction{};
+  double min_feature_fraction{};
+  overlap_strand strand{overlap_strand::any};
+};
+
+template <class Q, class F>
+bool overlap_accept(const Q &q, const F &f, const overlap_options &opts) {
+  const size_t start = std::max(q.get_start(), f.get_start());
+  const size_t end = std::min(q.get_end(), f.get_end());
+  if (end <= start)
+    return false;
+  const size_t overlap = end - start;
+  if (overlap < opts.min_query_fraction * (q.get_end() - q.get_start()) ||
+      overlap < opts.min_feature_fraction * (f.get_end() - f.get_start()))
+    return false;
+  const bool same = (q.get_strand() == f.get_strand());
+  return opts.strand == overlap_strand::any ||
+         (opts.strand == overlap_strand::same) == same;
+}
+
+/* The sweep, for n_q queries and n_f features given by functions from
+ * an index to a region, so any container or member can be used.
+ */
+template <class GetQ, class GetF>
+void overlap_join_sweep(const size_t n_q, GetQ get_q, const size_t n_f,
+                        GetF get_f, std::vector<size_t> &query_idx,
+                        std::vector<size_t> &feature_idx,
+                        const overlap_options &opts) {
+  query_idx.clear();
+  feature_idx.clear();
+  std::vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+
+  const auto check_sorted = [&ranks](const auto &prev, const auto &x,
+                                     const std::string &what) {
+    const chrom_id_type c = x.get_chrom_id();
+    const chrom_id_type prev_c = prev.get_chrom_id();
+    if ((c == prev_c) ? x.get_start() < prev.get_start()
+                      : ranks[c] < ranks[prev_c])
+      throw std::runtime_error(what + " not sorted near " +
+                               chrom_dict::name(c) + ":" +
+                               std::to_string(x.get_start()));
+  };
+
+  std::vector<size_t> active; // in the order of the features
+  size_t f = 0;               // the next feature to look at
+  const auto next_feature = [&]() {
+    if (f > 0)
+      check_sorted(get_f(f - 1), get_f(f), "features");
+    return f++;
+  };
+
+  for (size_t qi = 0; qi < n_q; ++qi) {
+    const auto &q = get_q(qi);
+    const chrom_id_type chrom = q.get_chrom_id();
+    if (qi > 0) {
+      check_sorted(get_q(qi - 1), q, "queries");
+      if (chrom != get_q(qi - 1).get_chrom_id())
+        active.clear();
+    }
+    // features on chroms before the query can't overlap it or later ones
+    while (f < n_f && ranks[get_f(f).get_chrom_id()] < ranks[chrom])
+      next_feature();
+    while (f < n_f && get_f(f).get_chrom_id() == chrom &&
+           get_f(f).get_start() < q.get_end())
+      active.push_back(next_feature());
+    // features that ended before this query did so for all later ones
+    size_t n_kept = 0;
+    for (const auto a : active) {
+      const auto &x = get_f(a);
+      if (x.get_end() <= q.get_start())
+        continue;
+      active[n_kept++] = a;
+      if (overlap_accept(q, x, opts)) {
+        query_idx.push_back(qi);
+        feature_idx.push_back(a);
+      }
+    }
+    active.resize(n_kept);
+  }
+  // the rest of the features still need to be checked
+  while (f < n_f)
+    next_feature();
+}
+
+/* For each overlapping query and feature, query_idx gets the index of
+ * the query and feature_idx that of the feature, ordered by query and
+ * then feature. Both inputs must be sorted by chrom and start, and a
+ * runtime_error is thrown if they are not. Both types need
+ * get_chrom_id, get_start, get_end and get_strand.
+ */
+template <class Q, class F>
+void overlap_join(const std::vector<Q> &queries,
+                  const std::vector<F> &features,
+                  std::vector<size_t> &query_idx,
+                  std::vector<size_t> &feature_idx,
+                  const overlap_options &opts = overlap_options()) {
+  overlap_join_sweep(
+      queries.size(), [&](const size_t i) -> const Q & { return queries[i]; },
+      features.size(), [&](const size_t i) -> const F & { return features[i]; },
+      query_idx, feature_idx, opts);
+}
+
+// the same, for reads
+template <class F>
+void overlap_join(const std::vector<MappedRead> &reads,
+                  const std::vector<F> &features,
+                  std::vector<size_t> &query_idx,
+                  std::vector<size_t> &feature_idx,
+                  const overlap_options &opts = overlap_options()) {
+  overlap_join_sweep(
+      reads.size(),
+      [&](const size_t i) -> const GenomicRegion & { return reads[i].r; },
+      features.size(), [&](const size_t i) -> const F & { return features[i]; },
+      query_idx, feature_idx, opts);
+}
+
+#endif
@@ -0,0 +1,119 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "parallel_sort.hpp"
+#include "chrom_dict.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::numeric_limits;
+using std::runtime_error;
+using std::vector;
+
+static bool mapped_read_less(const MappedRead &a, const MappedRead &b) {
+  return a.r < b.r;
+}
+
+void parallel_sort(vector<GenomicRegion> &regions, const size_t n_threads) {
+  parallel_sort(std::begin(regions), std::end(regions),
+                std::less<GenomicRegion>(), n_threads);
+}
+
+void parallel_stable_sort(vector<GenomicRegion> &regions,
+                          const size_t n_threads) {
+  parallel_stable_sort(std::begin(regions), std::end(regions),
+                       std::less<GenomicRegion>(), n_threads);
+}
+
+void parallel_sort(vector<MappedRead> &reads, const size_t n_threads) {
+  parallel_sort(std::begin(reads), std::end(reads), mapped_read_less,
+                n_threads);
+}
+
+void parallel_stable_sort(vector<MappedRead> &reads, const size_t n_threads) {
+  parallel_stable_sort(std::begin(reads), std::end(reads), mapped_read_less,
+                       n_threads);
+}
+
+struct sam_sort_key {
+  uint32_t chrom_rank;
+  uint32_t pos;
+  uint32_t rc;
+  uint32_t idx;
+  bool operator<(const sam_sort_key &rhs) const {
+    if (chrom_rank != rhs.chrom_rank)
+      return chrom_rank < rhs.chrom_rank;
+    if (pos != rhs.pos)
+      return pos < rhs.pos;
+    return rc < rhs.rc || (rc == rhs.rc && idx < rhs.idx);
+  }
+};
+
+/* Sorting the records directly would look up the reference name in
+ * chrom_dict for every comparison, so the keys are made once and sorted
+ * along with the index of each record. The index breaks ties, so the
+ * order is the same as that of a stable sort.
+ */
+static void sort_sam_records(vector<sam_rec> &records, const size_t n_threads) {
+  const size_t n = records.size();
+  if (n > numeric_limits<uint32_t>::max())
+    throw runtime_error("too many SAM records to sort");
+  vector<uint32_t> ranks;
+  vector<sam_sort_key> keys(n);
+  static const size_t block_size = 1 << 16;
+  const size_t n_blocks = (n + block_size - 1) / block_size;
+  // add the names first so the ranks are all from one ordering
+  run_tasks(n_blocks, n_threads, [&](const size_t b) {
+    const size_t end = std::min(n, (b + 1) * block_size);
+    for (size_t i = b * block_size; i < end; ++i)
+      keys[i].chrom_rank = records[i].rname == "*"
+                               ? numeric_limits<uint32_t>::max()
+                               : chrom_dict::assign(records[i].rname);
+  });
+  chrom_dict::get_ranks(ranks);
+  run_tasks(n_blocks, n_threads, [&](const size_t b) {
+    const size_t end = std::min(n, (b + 1) * block_size);
+    for (size_t i = b * block_size; i < end; ++i) {
+      sam_sort_key &k = keys[i];
+      if (k.chrom_rank != numeric_limits<uint32_t>::max())
+        k.chrom_rank = ranks[k.chrom_rank];
+      k.pos = records[i].pos;
+      k.rc = check_flag(records[i], samflags::read_rc);
+      k.idx = i;
+    }
+  });
+  parallel_sort(std::begin(keys), std::end(keys), std::less<sam_sort_key>(),
+                n_threads);
+  vector<sam_rec> sorted(n);
+  run_tasks(n_blocks, n_threads, [&](const size_t b) {
+    const size_t end = std::min(n, (b + 1) * block_size);
+    for (size_t i = b * block_size; i < end; ++i)
+      sorted[i] = std::move(records[keys[i].idx]);
+  });
+  std::swap(records, sorted);
+}
+
+void parallel_sort(vector<sam_rec> &records, const size_t n_threads) {
+  sort_sam_records(records, n_threads);
+}
+
+void parallel_stable_sort(vector<sam_rec> &records, const size_t n_threads) {
+  sort_sam_records(records, n_threads);
+}
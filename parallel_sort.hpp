@@ -0,0 +1,167 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef PARALLEL_SORT_HPP
+#define PARALLEL_SORT_HPP
+
+#include "GenomicRegion.hpp"
+#include "MappedRead.hpp"
+#include "parallel_tasks.hpp"
+#include "sam_record.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+/* The number of elements from [a, a + n_a) among the first k elements of
+ * the stable merge of [a, a + n_a) and [b, b + n_b), where elements of
+ * the first range come first among equal elements.
+ */
+template <class It, class Compare>
+size_t merge_split(const It a, const size_t n_a, const It b, const size_t n_b,
+                   const size_t k, Compare comp) {
+  size_t lo = k > n_b ? k - n_b : 0;
+  size_t hi = std::min(k, n_a);
+  while (lo < hi) {
+    const size_t i = lo + (hi - lo) / 2;
+    // a[i] precedes b[k - i - 1] in the merge, so more of a is needed
+    if (!comp(*(b + (k - i - 1)), *(a + i)))
+      lo = i + 1;
+    else
+      hi = i;
+  }
+  return lo;
+}
+
+/* Sort [first, last) using up to n_threads threads. The range is cut
+ * into one piece per thread and the pieces are sorted at the same
+ * time. Pairs of sorted runs are then merged, and each merge is itself
+ * split into pieces of equal size, so all threads stay busy even for
+ * the last merge. The stable version keeps equal elements in their
+ * input order, and gives the same result as std::stable_sort.
+ */
+template <class RandomIt, class Compare>
+void parallel_sort_runs(RandomIt first, RandomIt last, Compare comp,
+                        const size_t n_threads, const bool stable) {
+  typedef typename std::iterator_traits<RandomIt>::value_type T;
+
+  const size_t n = std::distance(first, last);
+  // below this size the threads cost more than they save
+  static const size_t min_run_size = 1 << 14;
+  const size_t n_runs =
+      std::max<size_t>(1, std::min(n_threads, n / min_run_size));
+
+  // run i is [bounds[i], bounds[i + 1])
+  std::vector<size_t> bounds(n_runs + 1);
+  for (size_t i = 0; i <= n_runs; ++i)
+    bounds[i] = (n * i) / n_runs;
+
+  run_tasks(n_runs, n_threads, [&](const size_t i) {
+    if (stable)
+      std::stable_sort(first + bounds[i], first + bounds[i + 1], comp);
+    else
+      std::sort(first + bounds[i], first + bounds[i + 1], comp);
+  });
+  if (n_runs == 1)
+    return;
+
+  std::vector<T> buffer(n);
+  // part of the output of merging run r with run r + 1
+  struct merge_piece {
+    size_t out_begin;
+    size_t out_end;
+    size_t run;
+  };
+  const size_t piece_size = (n + n_threads - 1) / n_threads;
+  bool in_buffer = false;
+  while (bounds.size() > 2) {
+    std::vector<merge_piece> pieces;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+      const size_t end = i + 2 < bounds.size() ? bounds[i + 2] : bounds[i + 1];
+      for (size_t j = bounds[i]; j < end; j += piece_size)
+        pieces.push_back({j, std::min(j + piece_size, end), i});
+    }
+    // reads from one of the two arrays and writes to the other
+    auto merge_one = [&](auto src, auto dst, const merge_piece &p) {
+      const size_t r = p.run;
+      const size_t a_begin = bounds[r], a_end = bounds[r + 1];
+      const size_t b_end = r + 2 < bounds.size() ? bounds[r + 2] : a_end;
+      const size_t n_a = a_end - a_begin, n_b = b_end - a_end;
+      const auto a = src + a_begin, b = src + a_end;
+      const size_t k_begin = p.out_begin - a_begin;
+      const size_t k_end = p.out_end - a_begin;
+      const size_t i_begin = merge_split(a, n_a, b, n_b, k_begin, comp);
+      const size_t i_end = merge_split(a, n_a, b, n_b, k_end, comp);
+      auto a_it = a + i_begin, b_it = b + (k_begin - i_begin);
+      const auto a_lim = a + i_end, b_lim = b + (k_end - i_end);
+      auto out = dst + p.out_begin;
+      while (a_it != a_lim && b_it != b_lim)
+        *out++ = comp(*b_it, *a_it) ? std::move(*b_it++) : std::move(*a_it++);
+      out = std::move(a_it, a_lim, out);
+      std::move(b_it, b_lim, out);
+    };
+    run_tasks(pieces.size(), n_threads, [&](const size_t i) {
+      if (in_buffer)
+        merge_one(std::begin(buffer), first, pieces[i]);
+      else
+        merge_one(first, std::begin(buffer), pieces[i]);
+    });
+    in_buffer = !in_buffer;
+    std::vector<size_t> merged_bounds;
+    for (size_t i = 0; i < bounds.size(); i += 2)
+      merged_bounds.push_back(bounds[i]);
+    if (merged_bounds.back() != n)
+      merged_bounds.push_back(n);
+    std::swap(bounds, merged_bounds);
+  }
+  if (in_buffer)
+    run_tasks(n_runs, n_threads, [&](const size_t i) {
+      const size_t b = (n * i) / n_runs, e = (n * (i + 1)) / n_runs;
+      std::move(std::begin(buffer) + b, std::begin(buffer) + e, first + b);
+    });
+}
+
+template <class RandomIt, class Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp,
+                   const size_t n_threads) {
+  parallel_sort_runs(first, last, comp, n_threads, false);
+}
+
+template <class RandomIt, class Compare>
+void parallel_stable_sort(RandomIt first, RandomIt last, Compare comp,
+                          const size_t n_threads) {
+  parallel_sort_runs(first, last, comp, n_threads, true);
+}
+
+/* Regions are sorted by operator<, and mapped reads by the operator<
+ * of their regions. Records in SAM format are sorted by the position
+ * where they map: chroms in the order of chrom_dict, then the position,
+ * then forward strand before reverse. Unmapped records, with "*" as
+ * the reference name, are put at the end.
+ */
+void parallel_sort(std::vector<GenomicRegion> &regions, const size_t n_threads);
+void parallel_stable_sort(std::vector<GenomicRegion> &regions,
+                          const size_t n_threads);
+
+void parallel_sort(std::vector<MappedRead> &reads, const size_t n_threads);
+void parallel_stable_sort(std::vector<MappedRead> &reads,
+                          const size_t n_threads);
+
+void parallel_sort(std::vector<sam_rec> &records, const size_t n_threads);
+void parallel_stable_sort(std::vector<sam_rec> &records,
+                          const size_t n_threads);
+
+#endif
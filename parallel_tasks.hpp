@@ -0,0 +1,63 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef PARALLEL_TASKS_HPP
+#define PARALLEL_TASKS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Call f(i) for each i in [0, n_tasks) using up to n_threads threads
+ * (including the calling thread). Tasks are handed out in order as
+ * threads become free, so put the largest tasks first. If any task
+ * throws, the remaining tasks are skipped and the first exception is
+ * rethrown once all threads have finished.
+ */
+template <class F>
+void run_tasks(const size_t n_tasks, const size_t n_threads, F f) {
+  const size_t n_workers = std::max<size_t>(1, std::min(n_threads, n_tasks));
+  std::atomic<size_t> next_task(0);
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&]() {
+    for (size_t i = next_task++; i < n_tasks && !failed; i = next_task++) {
+      try {
+        f(i);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+          error = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < n_workers; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &t : threads)
+    t.join();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+#endif
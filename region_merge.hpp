@@ -0,0 +1,295 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef REGION_MERGE_HPP
+#define REGION_MERGE_HPP
+
+#include "GenomicRegion.hpp"
+#include "chrom_dict.hpp"
+#include "parallel_tasks.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* Merging sorted regions into clusters, as collapse does, but keeping
+ * what is known about the regions in each cluster. Unlike collapse,
+ * regions that are near but don't overlap can be merged, regions can
+ * be merged only with others on the same strand, and the work is split
+ * over threads. The input is not changed.
+ */
+
+// the score given to each merged region
+enum class merge_score { count, sum, max, mean };
+
+// the name given to each merged region
+enum class merge_name {
+  first,  // of the first region in the cluster
+  concat, // of all regions in the cluster, in order, with a separator
+};
+
+struct merge_options {
+  // merge regions with at most this many bases between them, so with 0
+  // regions that touch are merged, which collapse doesn't do
+  size_t max_gap{};
+  bool by_strand{}; // merge only regions on the same strand
+  merge_score score{merge_score::sum};
+  merge_name name{merge_name::first};
+  char name_sep{','};
+};
+
+// the scores of the regions in a cluster
+struct merge_stats {
+  size_t count{};
+  double sum{};
+  double max{-std::numeric_limits<double>::infinity()};
+};
+
+inline double merge_score_value(const merge_stats &s, const merge_score score) {
+  switch (score) {
+  case merge_score::count:
+    return s.count;
+  case merge_score::sum:
+    return s.sum;
+  case merge_score::max:
+    return s.max;
+  case merge_score::mean:
+    return s.sum / s.count;
+  }
+  return 0.0;
+}
+
+// clusters already merged, as regions with their stats; names are only
+// used to build concatenated names, which can grow in place there
+struct merge_part {
+  std::vector<GenomicRegion> regions;
+  std::vector<merge_stats> stats;
+  std::vector<std::string> names;
+};
+
+// whether a region starting at start joins a cluster ending at end
+inline bool merge_near(const size_t start, const size_t end,
+                       const size_t max_gap) {
+  return start <= end || start - end <= max_gap;
+}
+
+// strands other than '+' and '-' are merged together
+inline size_t merge_strand_slot(const char strand, const bool by_strand) {
+  return !by_strand ? 0 : strand == '+' ? 0 : strand == '-' ? 1 : 2;
+}
+
+// add cluster j of other to cluster i of part
+inline void merge_into(merge_part &part, const size_t i,
+                       const merge_part &other, const size_t j,
+                       const merge_options &opts) {
+  GenomicRegion &r = part.regions[i];
+  r.set_end(std::max(r.get_end(), other.regions[j].get_end()));
+  merge_stats &s = part.stats[i];
+  s.count += other.stats[j].count;
+  s.sum += other.stats[j].sum;
+  s.max = std::max(s.max, other.stats[j].max);
+  if (opts.name == merge_name::concat) {
+    part.names[i] += opts.name_sep;
+    part.names[i] += other.names[j];
+  }
+}
+
+/* Merge regions [first, last), appending the clusters to out in the
+ * order of their first regions. Each region is checked against the one
+ * before it, including regions[first - 1], so the pieces of a split
+ * input together check all of it.
+ */
+template <class T>
+void merge_range(const std::vector<T> &regions, const size_t first,
+                 const size_t last, const std::vector<uint32_t> &ranks,
+                 const merge_options &opts, merge_part &out) {
+  static const size_t none = std::numeric_limits<size_t>::max();
+  size_t open[3] = {none, none, none}; // the last cluster of each strand
+  // at most one cluster per region; pages that aren't used cost nothing
+  out.regions.reserve(last - first);
+  out.stats.reserve(last - first);
+  for (size_t i = first; i < last; ++i) {
+    const T &x = regions[i];
+    const chrom_id_type chrom = x.get_chrom_id();
+    if (i > 0) {
+      const T &prev = regions[i - 1];
+      const chrom_id_type prev_chrom = prev.get_chrom_id();
+      if ((chrom == prev_chrom) ? x.get_start() < prev.get_start()
+                                : ranks[chrom] < ranks[prev_chrom])
+        throw std::runtime_error("regions not sorted near " +
+                                 chrom_dict::name(chrom) + ":" +
+                                 std::to_string(x.get_start()));
+      if (chrom != prev_chrom)
+        std::fill_n(open, 3, none);
+    }
+    const size_t slot = merge_strand_slot(x.get_strand(), opts.by_strand);
+    const size_t o = open[slot];
+    if (o != none &&
+        merge_near(x.get_start(), out.regions[o].get_end(), opts.max_gap)) {
+      GenomicRegion &r = out.regions[o];
+      merge_stats &s = out.stats[o];
+      r.set_end(std::max(r.get_end(), x.get_end()));
+      ++s.count;
+      s.sum += x.get_score();
+      s.max = std::max(s.max, static_cast<double>(x.get_score()));
+      if (opts.name == merge_name::concat) {
+        out.names[o] += opts.name_sep;
+        out.names[o] += x.get_name();
+      }
+    }
+    else {
+      open[slot] = out.regions.size();
+      const bool concat = (opts.name == merge_name::concat);
+      out.regions.emplace_back(chrom, x.get_start(), x.get_end(),
+                               concat ? std::string_view() : x.get_name(),
+                               x.get_score(), x.get_strand());
+      out.stats.push_back({1, x.get_score(), x.get_score()});
+      if (concat)
+        out.names.emplace_back(x.get_name());
+    }
+  }
+}
+
+// the last cluster of each strand on the chrom of the last cluster
+struct merge_open {
+  chrom_id_type chrom{};
+  size_t idx[3] = {std::numeric_limits<size_t>::max(),
+                   std::numeric_limits<size_t>::max(),
+                   std::numeric_limits<size_t>::max()};
+};
+
+// make cluster i of part, which comes after all others, the open one
+inline void merge_track(merge_open &open, const merge_part &part,
+                        const size_t i, const merge_options &opts) {
+  const GenomicRegion &r = part.regions[i];
+  if (r.get_chrom_id() != open.chrom) {
+    open.chrom = r.get_chrom_id();
+    std::fill_n(open.idx, 3, std::numeric_limits<size_t>::max());
+  }
+  open.idx[merge_strand_slot(r.get_strand(), opts.by_strand)] = i;
+}
+
+/* Join the clusters of the next piece of the input to those merged so
+ * far, whose open clusters are kept in open. Only clusters at the start
+ * of the piece can merge with earlier ones: once a cluster starts too
+ * far from every cluster still open, the rest of the piece is copied.
+ */
+inline void merge_append(merge_part &merged, merge_part &piece,
+                         merge_open &open, const merge_options &opts) {
+  static const size_t none = std::numeric_limits<size_t>::max();
+  const chrom_id_type chrom = piece.regions.front().get_chrom_id();
+  bool joining = false;
+  size_t max_open_end = 0;
+  if (open.chrom == chrom)
+    for (const auto o : open.idx)
+      if (o != none) {
+        joining = true;
+        max_open_end = std::max(max_open_end, merged.regions[o].get_end());
+      }
+  for (size_t k = 0; k < piece.regions.size(); ++k) {
+    GenomicRegion &x = piece.regions[k];
+    joining = joining && x.get_chrom_id() == chrom &&
+              merge_near(x.get_start(), max_open_end, opts.max_gap);
+    const size_t slot = merge_strand_slot(x.get_strand(), opts.by_strand);
+    const size_t o = joining ? open.idx[slot] : none;
+    if (o != none &&
+        merge_near(x.get_start(), merged.regions[o].get_end(), opts.max_gap)) {
+      merge_into(merged, o, piece, k, opts);
+      max_open_end = std::max(max_open_end, merged.regions[o].get_end());
+    }
+    else {
+      if (joining)
+        max_open_end = std::max(max_open_end, x.get_end());
+      merged.regions.push_back(std::move(x));
+      merged.stats.push_back(piece.stats[k]);
+      if (opts.name == merge_name::concat)
+        merged.names.emplace_back(std::move(piece.names[k]));
+      merge_track(open, merged, merged.regions.size() - 1, opts);
+    }
+  }
+}
+
+/* Merge sorted regions into clusters, giving one region for each
+ * cluster and the count, sum and largest of the scores of its regions.
+ * The merged regions have the chrom, start and strand of the first
+ * region in the cluster, the largest end, the name chosen in opts, and
+ * the score chosen in opts. Regions must be sorted by chrom and start,
+ * and a runtime_error is thrown if they are not. The input is split
+ * into pieces merged in parallel, and the clusters that cross pieces
+ * are joined after, so the result is the same for any n_threads.
+ */
+template <class T>
+void merge_regions(const std::vector<T> &regions,
+                   std::vector<GenomicRegion> &merged,
+                   std::vector<merge_stats> &stats,
+                   const merge_options &opts = merge_options(),
+                   const size_t n_threads = 1) {
+  std::vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+
+  const size_t n = regions.size();
+  // one piece for one thread, so nothing needs to be joined
+  const size_t n_pieces_wanted = n_threads <= 1 ? 1 : 4 * n_threads;
+  const size_t piece_size = std::max<size_t>(
+      1, (n + n_pieces_wanted - 1) / n_pieces_wanted);
+  const size_t n_pieces = (n + piece_size - 1) / piece_size;
+  std::vector<merge_part> pieces(n_pieces);
+  run_tasks(n_pieces, n_threads, [&](const size_t p) {
+    merge_range(regions, p * piece_size, std::min(n, (p + 1) * piece_size),
+                ranks, opts, pieces[p]);
+  });
+
+  size_t n_clusters = 0;
+  for (const auto &p : pieces)
+    n_clusters += p.regions.size();
+  merge_part all;
+  merge_open open;
+  if (!pieces.empty())
+    all = std::move(pieces.front());
+  all.regions.reserve(n_clusters);
+  all.stats.reserve(n_clusters);
+  for (size_t i = 0; i < all.regions.size(); ++i)
+    merge_track(open, all, i, opts);
+  for (size_t p = 1; p < n_pieces; ++p) {
+    merge_append(all, pieces[p], open, opts);
+    pieces[p] = merge_part(); // release the memory as we go
+  }
+
+  for (size_t i = 0; i < all.regions.size(); ++i) {
+    all.regions[i].set_score(merge_score_value(all.stats[i], opts.score));
+    if (opts.name == merge_name::concat)
+      all.regions[i].set_name(all.names[i]);
+  }
+  merged.swap(all.regions);
+  stats.swap(all.stats);
+}
+
+// the same, without the stats
+template <class T>
+void merge_regions(const std::vector<T> &regions,
+                   std::vector<GenomicRegion> &merged,
+                   const merge_options &opts = merge_options(),
+                   const size_t n_threads = 1) {
+  std::vector<merge_stats> stats;
+  merge_regions(regions, merged, stats, opts, n_threads);
+}
+
+#endif
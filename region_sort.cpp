@@ -0,0 +1,197 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "region_sort.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using std::array;
+using std::vector;
+
+static const size_t max_key_fields = 4;
+
+template <size_t n_words> struct region_sort_rec {
+  uint64_t key[n_words]; // key[0] holds the least significant bits
+  size_t idx;
+};
+
+static size_t n_bits(uint64_t x) {
+  size_t b = 0;
+  for (; x != 0; x >>= 1)
+    ++b;
+  return b;
+}
+
+// values of char in increasing order, whether or not char is signed
+static uint64_t strand_value(const char c) {
+  return static_cast<uint64_t>(static_cast<int>(c) -
+                               std::numeric_limits<char>::min());
+}
+
+// the fields of the key, most significant first; T is GenomicRegion or
+// CompactRegion
+template <class T>
+static size_t key_fields(const T &r, const region_order order,
+                         const vector<uint32_t> &ranks, uint64_t *f) {
+  const bool by_start = (order == region_order::start_first);
+  f[0] = ranks[r.get_chrom_id()];
+  f[1] = by_start ? r.get_start() : r.get_end();
+  f[2] = by_start ? r.get_end() : r.get_start();
+  f[3] = strand_value(r.get_strand());
+  return 4;
+}
+
+static size_t key_fields(const SimpleGenomicRegion &r, const region_order order,
+                         const vector<uint32_t> &ranks, uint64_t *f) {
+  const bool by_start = (order == region_order::start_first);
+  f[0] = ranks[r.get_chrom_id()];
+  f[1] = by_start ? r.get_start() : r.get_end();
+  f[2] = by_start ? r.get_end() : r.get_start();
+  return 3;
+}
+
+template <size_t n_words>
+static size_t key_digit(const region_sort_rec<n_words> &r, const size_t d) {
+  return (r.key[d / 8] >> (8 * (d % 8))) & 0xff;
+}
+
+template <size_t n_words>
+static void lsd_radix_sort(vector<region_sort_rec<n_words>> &recs,
+                           const size_t total_bits) {
+  const size_t n = recs.size();
+  const size_t n_digits = (total_bits + 7) / 8;
+
+  // one pass to count every digit
+  vector<array<size_t, 256>> counts(n_digits);
+  for (auto &c : counts)
+    c.fill(0);
+  for (const auto &r : recs)
+    for (size_t d = 0; d < n_digits; ++d)
+      ++counts[d][key_digit(r, d)];
+
+  vector<region_sort_rec<n_words>> buf(n);
+  array<size_t, 256> offset{};
+  for (size_t d = 0; d < n_digits; ++d) {
+    const auto &c = counts[d];
+    if (std::find(begin(c), end(c), n) != end(c))
+      continue; // all keys have the same digit here
+    size_t total = 0;
+    for (size_t i = 0; i < 256; ++i) {
+      offset[i] = total;
+      total += c[i];
+    }
+    for (const auto &r : recs)
+      buf[offset[key_digit(r, d)]++] = r;
+    recs.swap(buf);
+  }
+}
+
+template <size_t n_words, class T>
+static void radix_sort_regions(vector<T> &regions, const region_order order,
+                               const vector<uint32_t> &ranks,
+                               const uint64_t *field_min,
+                               const size_t *field_bits,
+                               const size_t total_bits) {
+  const size_t n = regions.size();
+  vector<region_sort_rec<n_words>> recs(n);
+  uint64_t f[max_key_fields];
+  for (size_t i = 0; i < n; ++i) {
+    const size_t n_fields = key_fields(regions[i], order, ranks, f);
+    uint64_t key[2] = {0, 0};
+    for (size_t k = 0; k < n_fields; ++k) {
+      const size_t b = field_bits[k];
+      const uint64_t v = f[k] - field_min[k];
+      if (b == 0)
+        continue;
+      if (b == 64) {
+        key[1] = key[0];
+        key[0] = v;
+      }
+      else {
+        key[1] = (key[1] << b) | (key[0] >> (64 - b));
+        key[0] = (key[0] << b) | v;
+      }
+    }
+    for (size_t w = 0; w < n_words; ++w)
+      recs[i].key[w] = key[w];
+    recs[i].idx = i;
+  }
+
+  lsd_radix_sort(recs, total_bits);
+
+  vector<T> sorted;
+  sorted.reserve(n);
+  for (const auto &r : recs)
+    sorted.push_back(std::move(regions[r.idx]));
+  regions.swap(sorted);
+}
+
+template <class T>
+static void sort_regions_impl(vector<T> &regions, const region_order order) {
+  if (regions.size() < 2)
+    return;
+
+  vector<uint32_t> ranks;
+  chrom_dict::get_ranks(ranks);
+
+  uint64_t f[max_key_fields];
+  uint64_t field_min[max_key_fields], field_max[max_key_fields];
+  std::fill_n(field_min, max_key_fields, std::numeric_limits<uint64_t>::max());
+  std::fill_n(field_max, max_key_fields, 0);
+  size_t n_fields = 0;
+  for (const auto &r : regions) {
+    n_fields = key_fields(r, order, ranks, f);
+    for (size_t k = 0; k < n_fields; ++k) {
+      field_min[k] = std::min(field_min[k], f[k]);
+      field_max[k] = std::max(field_max[k], f[k]);
+    }
+  }
+  size_t field_bits[max_key_fields];
+  size_t total_bits = 0;
+  for (size_t k = 0; k < n_fields; ++k) {
+    field_bits[k] = n_bits(field_max[k] - field_min[k]);
+    total_bits += field_bits[k];
+  }
+
+  if (total_bits <= 64)
+    radix_sort_regions<1>(regions, order, ranks, field_min, field_bits,
+                          total_bits);
+  else if (total_bits <= 128)
+    radix_sort_regions<2>(regions, order, ranks, field_min, field_bits,
+                          total_bits);
+  else if (order == region_order::start_first)
+    std::stable_sort(begin(regions), end(regions));
+  else
+    std::stable_sort(begin(regions), end(regions),
+                     [](const T &a, const T &b) { return a.less1(b); });
+}
+
+void sort_regions(vector<GenomicRegion> &regions, const region_order order) {
+  sort_regions_impl(regions, order);
+}
+
+void sort_regions(vector<SimpleGenomicRegion> &regions,
+                  const region_order order) {
+  sort_regions_impl(regions, order);
+}
+
+void sort_regions(vector<CompactRegion> &regions, const region_order order) {
+  sort_regions_impl(regions, order);
+}
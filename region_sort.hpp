@@ -0,0 +1,47 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef REGION_SORT_HPP
+#define REGION_SORT_HPP
+
+#include "CompactRegion.hpp"
+#include "GenomicRegion.hpp"
+
+#include <vector>
+
+enum class region_order {
+  start_first, // as operator<
+  end_first,   // as less1, needed by genomic_region_intersection_by_base
+};
+
+/* Sort regions with an LSD radix sort. Each region gets a key packing
+ * the chrom rank, start, end and strand, with each field using only as
+ * many bits as the range of its values in the input needs. Keys up to
+ * 128 bits are sorted 8 bits at a time, skipping digits that are the
+ * same for all regions, and the regions are then moved into place. The
+ * order is exactly that of operator< (or less1), and regions that
+ * compare equal keep their input order. If the keys would need more
+ * than 128 bits, this falls back to std::stable_sort.
+ */
+void sort_regions(std::vector<GenomicRegion> &regions,
+                  const region_order order = region_order::start_first);
+
+void sort_regions(std::vector<SimpleGenomicRegion> &regions,
+                  const region_order order = region_order::start_first);
+
+void sort_regions(std::vector<CompactRegion> &regions,
+                  const region_order order = region_order::start_first);
+
+#endif
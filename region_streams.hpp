@@ -0,0 +1,356 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef REGION_STREAMS_HPP
+#define REGION_STREAMS_HPP
+
+#include "GenomicRegion.hpp"
+#include "chrom_dict.hpp"
+#include "closest.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Set operations on streams of sorted regions, each in one pass and
+ * with constant memory. A stream is anything with a member
+ *
+ *   bool read(GenomicRegion &r);
+ *
+ * that gives regions in the order of GenomicRegion::operator< and
+ * returns false at the end, like BedReader and BedMerger. Each
+ * operation is also a stream, so they can be chained without making
+ * the intermediate sets:
+ *
+ *   BedReader a(a_file), b(b_file), c(c_file);
+ *   RegionSetOp a_and_b(a, b, region_set_op::intersect);
+ *   RegionSetOp result(a_and_b, c, region_set_op::subtract);
+ *   GenomicRegion r;
+ *   while (result.read(r))
+ *     out.write(r);
+ *
+ * The results are sets of bases, given as disjoint regions that don't
+ * touch, with no name, score 0 and strand '+'. Inputs may overlap.
+ * Streams are held by reference and must outlive the operation.
+ */
+
+// a stream over a vector of regions of any type
+template <class T> class RegionVectorReader {
+public:
+  explicit RegionVectorReader(const std::vector<T> &regions)
+      : regions(regions) {}
+  bool read(GenomicRegion &r) {
+    if (i == regions.size())
+      return false;
+    const T &x = regions[i++];
+    r.set_chrom_id(x.get_chrom_id());
+    r.set_start(x.get_start());
+    r.set_end(x.get_end());
+    return true;
+  }
+
+private:
+  const std::vector<T> &regions;
+  size_t i{};
+};
+
+// a run of covered bases on a chrom
+struct region_run {
+  chrom_id_type chrom{};
+  size_t start{};
+  size_t end{};
+};
+
+inline void set_run_region(const region_run &run, GenomicRegion &r) {
+  r.set_chrom_id(run.chrom);
+  r.set_start(run.start);
+  r.set_end(run.end);
+  r.set_name("");
+  r.set_score(0);
+  r.set_strand('+');
+}
+
+/* Reads a stream and gives the bases it covers as disjoint runs, joining
+ * regions that overlap or touch. Throws if the stream isn't sorted.
+ */
+template <class S> class RegionRunReader {
+public:
+  explicit RegionRunReader(S &in) : in(in) { has_next = next_nonempty(); }
+
+  bool read(region_run &run) {
+    if (!has_next)
+      return false;
+    run = {next.get_chrom_id(), next.get_start(), next.get_end()};
+    while ((has_next = next_nonempty()) &&
+           next.get_chrom_id() == run.chrom && next.get_start() <= run.end)
+      run.end = std::max(run.end, next.get_end());
+    return true;
+  }
+
+private:
+  // empty regions cover no bases, so they are skipped
+  bool next_nonempty() {
+    while (in.read(next)) {
+      if (n_read++ > 0 &&
+          (chrom_dict::less(next.get_chrom_id(), last_chrom) ||
+           (next.get_chrom_id() == last_chrom &&
+            next.get_start() < last_start)))
+        throw std::runtime_error("regions not sorted near " +
+                                 next.get_chrom() + ":" +
+                                 std::to_string(next.get_start()));
+      last_chrom = next.get_chrom_id();
+      last_start = next.get_start();
+      if (next.get_start() < next.get_end())
+        return true;
+    }
+    return false;
+  }
+
+  S &in;
+  GenomicRegion next;
+  bool has_next{};
+  size_t n_read{};
+  chrom_id_type last_chrom{};
+  size_t last_start{};
+};
+
+enum class region_set_op {
+  unite,     // bases in either stream
+  intersect, // bases in both streams
+  subtract,  // bases in the first stream and not the second
+};
+
+/* The bases given by a set operation on two streams. The two streams
+ * are swept together, one boundary of a run at a time, and a run of
+ * output ends when the operation stops being true.
+ */
+template <class A, class B> class RegionSetOp {
+public:
+  RegionSetOp(A &a_in, B &b_in, const region_set_op op)
+      : a(a_in), b(b_in), op(op) {
+    has_a = a.read(run_a);
+    has_b = b.read(run_b);
+    next_chrom();
+  }
+
+  bool read(GenomicRegion &r) {
+    static const size_t none = std::numeric_limits<size_t>::max();
+    while (true) {
+      const size_t next_a =
+          (has_a && run_a.chrom == chrom) ? (in_a ? run_a.end : run_a.start)
+                                          : none;
+      const size_t next_b =
+          (has_b && run_b.chrom == chrom) ? (in_b ? run_b.end : run_b.start)
+                                          : none;
+      if (next_a == none && next_b == none) {
+        // nothing is open, so go to the next chrom of either stream
+        if (!has_a && !has_b)
+          return false;
+        next_chrom();
+        continue;
+      }
+      const size_t pos = std::min(next_a, next_b);
+      if (next_a == pos) {
+        if (in_a)
+          has_a = a.read(run_a);
+        in_a = !in_a;
+      }
+      if (next_b == pos) {
+        if (in_b)
+          has_b = b.read(run_b);
+        in_b = !in_b;
+      }
+      const bool now_in = (op == region_set_op::unite)       ? in_a || in_b
+                          : (op == region_set_op::intersect) ? in_a && in_b
+                                                             : in_a && !in_b;
+      if (now_in && !in_out)
+        out_start = pos;
+      const bool done = !now_in && in_out;
+      in_out = now_in;
+      if (done) {
+        set_run_region({chrom, out_start, pos}, r);
+        return true;
+      }
+    }
+  }
+
+private:
+  // the first chrom of the next run in either stream
+  void next_chrom() {
+    if (has_a || has_b)
+      chrom = (!has_b || (has_a && chrom_dict::less(run_a.chrom, run_b.chrom)))
+                  ? run_a.chrom
+                  : run_b.chrom;
+  }
+
+  RegionRunReader<A> a;
+  RegionRunReader<B> b;
+  region_set_op op;
+  region_run run_a, run_b;
+  bool has_a{}, has_b{};
+  // whether the last boundary passed was a start for each
+  bool in_a{}, in_b{}, in_out{};
+  chrom_id_type chrom{};
+  size_t out_start{};
+};
+
+/* The bases not covered by a stream, on the chroms of a chrom sizes
+ * file, in chrom_dict order. Chroms with no regions are given whole.
+ * Throws if the stream has a region on a chrom not in the list.
+ */
+template <class S> class RegionComplement {
+public:
+  RegionComplement(S &s, const std::vector<std::string> &chroms,
+                   const std::vector<size_t> &sizes)
+      : in(s) {
+    if (chroms.size() != sizes.size())
+      throw std::runtime_error("different numbers of chrom names and sizes");
+    for (size_t i = 0; i < chroms.size(); ++i)
+      chrom_sizes.push_back({chrom_dict::assign(chroms[i]), 0, sizes[i]});
+    std::sort(std::begin(chrom_sizes), std::end(chrom_sizes),
+              [](const region_run &x, const region_run &y) {
+                return chrom_dict::less(x.chrom, y.chrom);
+              });
+    has_run = in.read(run);
+  }
+
+  bool read(GenomicRegion &r) {
+    while (c < chrom_sizes.size()) {
+      const region_run &chrom = chrom_sizes[c];
+      if (has_run && chrom_dict::less(run.chrom, chrom.chrom))
+        throw std::runtime_error("chrom not in chrom sizes: " +
+                                 chrom_dict::name(run.chrom));
+      if (has_run && run.chrom == chrom.chrom) {
+        const size_t gap_end = std::min(run.start, chrom.end);
+        const size_t gap_start = pos;
+        pos = std::max(pos, run.end);
+        has_run = in.read(run);
+        if (gap_start < gap_end) {
+          set_run_region({chrom.chrom, gap_start, gap_end}, r);
+          return true;
+        }
+        continue;
+      }
+      // no more regions on this chrom
+      const size_t gap_start = pos;
+      ++c;
+      pos = 0;
+      if (gap_start < chrom.end) {
+        set_run_region({chrom.chrom, gap_start, chrom.end}, r);
+        return true;
+      }
+    }
+    if (has_run)
+      throw std::runtime_error("chrom not in chrom sizes: " +
+                               chrom_dict::name(run.chrom));
+    return false;
+  }
+
+private:
+  RegionRunReader<S> in;
+  std::vector<region_run> chrom_sizes; // start is not used
+  region_run run;
+  bool has_run{};
+  size_t c{};   // the current chrom
+  size_t pos{}; // the first base on it that could start a gap
+};
+
+/* For each region of stream a, the nearest region of stream b on the
+ * same chrom, with the distance of GenomicRegion::distance. Only the
+ * region of b with the largest end so far and the next region of b are
+ * kept: any other region of b before a is no nearer than the first,
+ * and any after it no nearer than the second. If b has no region on the
+ * chrom, the distance is closest_none and the region of b is unchanged.
+ * The regions of both streams are given whole, not as runs, but empty
+ * regions of b are skipped.
+ */
+template <class A, class B> class RegionClosest {
+public:
+  RegionClosest(A &a, B &b) : a(a), b(b) { has_ahead = next_b(); }
+
+  bool read(GenomicRegion &region_a, GenomicRegion &region_b,
+            size_t &distance) {
+    if (!a.read(region_a))
+      return false;
+    const chrom_id_type chrom = region_a.get_chrom_id();
+    if (n_read++ > 0 &&
+        (chrom_dict::less(chrom, last_chrom) ||
+         (chrom == last_chrom && region_a.get_start() < last_start)))
+      throw std::runtime_error("regions not sorted near " +
+                               region_a.get_chrom() + ":" +
+                               std::to_string(region_a.get_start()));
+    if (chrom != last_chrom)
+      has_left = false;
+    last_chrom = chrom;
+    last_start = region_a.get_start();
+
+    while (has_ahead && (chrom_dict::less(ahead.get_chrom_id(), chrom) ||
+                         (ahead.get_chrom_id() == chrom &&
+                          ahead.get_start() < region_a.get_start()))) {
+      if (ahead.get_chrom_id() == chrom &&
+          (!has_left || ahead.get_end() > left.get_end())) {
+        left.swap(ahead);
+        has_left = true;
+      }
+      has_ahead = next_b();
+    }
+
+    distance = closest_none;
+    if (has_left) {
+      distance = region_distance(region_a, left);
+      region_b = left;
+    }
+    if (has_ahead && ahead.get_chrom_id() == chrom) {
+      const size_t d = region_distance(region_a, ahead);
+      if (d < distance) {
+        distance = d;
+        region_b = ahead;
+      }
+    }
+    return true;
+  }
+
+private:
+  // empty regions of b are skipped, as they would be nearer than regions
+  // that start at the same place and overlap a
+  bool next_b() {
+    while (b.read(ahead)) {
+      if (n_read_b++ > 0 &&
+          (chrom_dict::less(ahead.get_chrom_id(), b_chrom) ||
+           (ahead.get_chrom_id() == b_chrom && ahead.get_start() < b_start)))
+        throw std::runtime_error("regions not sorted near " +
+                                 ahead.get_chrom() + ":" +
+                                 std::to_string(ahead.get_start()));
+      b_chrom = ahead.get_chrom_id();
+      b_start = ahead.get_start();
+      if (ahead.get_start() < ahead.get_end())
+        return true;
+    }
+    return false;
+  }
+
+  A &a;
+  B &b;
+  GenomicRegion left, ahead;
+  bool has_left{}, has_ahead{};
+  size_t n_read{}, n_read_b{};
+  chrom_id_type last_chrom{}, b_chrom{};
+  size_t last_start{}, b_start{};
+};
+
+#endif
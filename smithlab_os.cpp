@@ -20,6 +20,8 @@
 #include "smithlab_utils.hpp"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -576,3 +578,52 @@ bool has_gz_ext(const string &filename) {
   return filename.size() >= ext.size() &&
          filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
 }
+
+MappedFile::MappedFile(const string &filename)
+    : file_data(nullptr), file_size(0) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw runtime_error("failed to open file " + filename);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    throw runtime_error("failed to open file " + filename);
+  }
+  file_size = st.st_size;
+  if (file_size > 0) {
+    void *p = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      throw runtime_error("failed to map file " + filename + ": " +
+                          std::strerror(errno));
+    }
+    // the file is scanned front to back, so ask for aggressive read-ahead
+    madvise(p, file_size, MADV_SEQUENTIAL);
+    file_data = static_cast<const char *>(p);
+  }
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (file_data != nullptr)
+    munmap(const_cast<char *>(file_data), file_size);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : file_data(other.file_data), file_size(other.file_size) {
+  other.file_data = nullptr;
+  other.file_size = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    if (file_data != nullptr)
+      munmap(const_cast<char *>(file_data), file_size);
+    file_data = other.file_data;
+    file_size = other.file_size;
+    other.file_data = nullptr;
+    other.file_size = 0;
+  }
+  return *this;
+}
@@ -91,4 +91,29 @@ bool is_valid_output_file(const std::string &filename);
 
 bool has_gz_ext(const std::string &filename);
 
+/* MappedFile: the contents of a file mapped read-only into memory, for
+ * parsers that want to scan a whole file without copying it. The
+ * mapping is released when the object is destroyed. An empty file gives
+ * size() == 0 and data() == nullptr.
+ */
+class MappedFile {
+public:
+  MappedFile() : file_data(nullptr), file_size(0) {}
+  explicit MappedFile(const std::string &filename);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  const char *data() const { return file_data; }
+  size_t size() const { return file_size; }
+  const char *begin() const { return file_data; }
+  const char *end() const { return file_data + file_size; }
+
+private:
+  const char *file_data;
+  size_t file_size;
+};
+
 #endif
@@ -0,0 +1,143 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#include "string_pool.hpp"
+
+#include <cassert>
+#include <functional>
+#include <stdexcept>
+
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::mutex;
+using std::runtime_error;
+using std::string_view;
+
+StringPool::table::table(const size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<const entry *>[capacity]) {
+  for (size_t i = 0; i < capacity; ++i)
+    slots[i].store(nullptr, memory_order_relaxed);
+}
+
+StringPool::StringPool() : n_entries(0) {
+  tables.emplace_back(new table(2 * first_segment_size));
+  current.store(tables.back().get(), memory_order_release);
+  for (auto &s : segments)
+    s.store(nullptr, memory_order_relaxed);
+}
+
+StringPool::~StringPool() {
+  for (auto &s : segments)
+    delete[] s.load(memory_order_relaxed);
+}
+
+size_t StringPool::segment_of(const uint32_t id, size_t &offset) {
+  // segment k starts at first_segment_size * (2^k - 1)
+  const size_t q = (static_cast<size_t>(id) >> first_segment_bits) + 1;
+  size_t k = 0;
+  while ((q >> (k + 1)) != 0)
+    ++k;
+  offset = id - first_segment_size * ((1ul << k) - 1);
+  return k;
+}
+
+const StringPool::entry &StringPool::entry_at(const uint32_t id) const {
+  size_t offset = 0;
+  const size_t k = segment_of(id, offset);
+  const entry *seg = segments[k].load(memory_order_acquire);
+  assert(seg != nullptr);
+  return seg[offset];
+}
+
+StringPool::entry &StringPool::new_entry(const uint32_t id) {
+  // called with the write lock held
+  size_t offset = 0;
+  const size_t k = segment_of(id, offset);
+  if (k >= max_segments)
+    throw runtime_error("too many distinct strings in pool");
+  entry *seg = segments[k].load(memory_order_relaxed);
+  if (seg == nullptr) {
+    seg = new entry[first_segment_size << k];
+    segments[k].store(seg, memory_order_release);
+  }
+  return seg[offset];
+}
+
+void StringPool::insert(table &t, const entry *e) {
+  size_t i = e->hash & t.mask;
+  while (t.slots[i].load(memory_order_relaxed) != nullptr)
+    i = (i + 1) & t.mask;
+  t.slots[i].store(e, memory_order_release);
+}
+
+bool StringPool::find(const string_view s, const size_t h,
+                      uint32_t &id) const {
+  const table *t = current.load(memory_order_acquire);
+  // the table is never more than half full, so this finds an empty slot
+  for (size_t i = h & t->mask;; i = (i + 1) & t->mask) {
+    const entry *e = t->slots[i].load(memory_order_acquire);
+    if (e == nullptr)
+      return false;
+    if (e->hash == h && e->str == s) {
+      id = e->id;
+      return true;
+    }
+  }
+}
+
+bool StringPool::find(const string_view s, uint32_t &id) const {
+  return find(s, std::hash<string_view>{}(s), id);
+}
+
+uint32_t StringPool::assign(const string_view s) {
+  const size_t h = std::hash<string_view>{}(s);
+  uint32_t id = 0;
+  if (find(s, h, id))
+    return id;
+
+  lock_guard<mutex> lock(write_mutex);
+  if (find(s, h, id)) // another thread might have added it
+    return id;
+
+  id = n_entries.load(memory_order_relaxed);
+  entry &e = new_entry(id);
+  e.str = s;
+  e.hash = h;
+  e.id = id;
+
+  table *t = current.load(memory_order_relaxed);
+  if (2 * (static_cast<size_t>(id) + 1) > t->mask + 1) {
+    // readers still holding the old table miss only the new strings, and
+    // those readers then take the lock and look again
+    tables.emplace_back(new table(2 * (t->mask + 1)));
+    t = tables.back().get();
+    for (uint32_t i = 0; i < id; ++i)
+      insert(*t, &entry_at(i));
+    insert(*t, &e);
+    current.store(t, memory_order_release);
+  }
+  else
+    insert(*t, &e);
+
+  n_entries.store(id + 1, memory_order_release);
+  return id;
+}
+
+const std::string &StringPool::get(const uint32_t id) const {
+  assert(id < size());
+  return entry_at(id).str;
+}
@@ -0,0 +1,82 @@
+/* Copyright (C) 2026 Andrew D. Smith
+ *
+ * Authors: Andrew D. Smith
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ */
+
+#ifndef STRING_POOL_HPP
+#define STRING_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* StringPool: assigns each distinct string a dense id (0, 1, 2, ...)
+ * and can be shared by any number of threads. Looking up a string or
+ * an id never takes a lock: the strings live in segments that are never
+ * moved, and the hash table from strings to ids is an open-addressing
+ * table of atomic pointers, replaced by a larger copy when it fills.
+ * Only adding a new string takes a lock, and the lock is only held for
+ * the insertion itself. References returned by get() remain valid for
+ * the lifetime of the pool.
+ */
+class StringPool {
+public:
+  StringPool();
+  ~StringPool();
+  StringPool(const StringPool &) = delete;
+  StringPool &operator=(const StringPool &) = delete;
+
+  // the id of s, adding s if it is new
+  uint32_t assign(const std::string_view s);
+  // the id of s if s is already in the pool
+  bool find(const std::string_view s, uint32_t &id) const;
+  // the string for an id returned by assign or find
+  const std::string &get(const uint32_t id) const;
+  size_t size() const { return n_entries.load(std::memory_order_acquire); }
+
+private:
+  struct entry {
+    std::string str;
+    size_t hash{};
+    uint32_t id{};
+  };
+  struct table {
+    explicit table(const size_t capacity);
+    size_t mask;
+    std::unique_ptr<std::atomic<const entry *>[]> slots;
+  };
+
+  // segment k holds (first_segment_size << k) entries
+  static const size_t first_segment_bits = 6;
+  static const size_t first_segment_size = 1ul << first_segment_bits;
+  static const size_t max_segments = 27;
+
+  static size_t segment_of(const uint32_t id, size_t &offset);
+  bool find(const std::string_view s, const size_t h, uint32_t &id) const;
+  const entry &entry_at(const uint32_t id) const;
+  entry &new_entry(const uint32_t id);
+  static void insert(table &t, const entry *e);
+
+  std::mutex write_mutex;
+  std::atomic<uint32_t> n_entries;
+  std::atomic<table *> current;
+  std::vector<std::unique_ptr<table>> tables; // includes retired tables
+  std::atomic<entry *> segments[max_segments];
+};
+
+#endif